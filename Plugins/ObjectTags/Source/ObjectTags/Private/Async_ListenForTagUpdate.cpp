@@ -23,19 +23,18 @@ UAsync_ListenForTagUpdate* UAsync_ListenForTagUpdate::ListenForTagUpdate(UObject
 
 void UAsync_ListenForTagUpdate::Activate()
 {
-	UObjectTags_Subsystem::AddListenerToObject(this, ObjectToTrack);
+	SubscriptionHandle = UObjectTags_Subsystem::SubscribeToTag(ObjectToTrack, TagToTrack,
+		FOnObjectTagChanged::CreateUObject(this, &UAsync_ListenForTagUpdate::OnTrackedTagChanged));
 }
 
 void UAsync_ListenForTagUpdate::Cancel()
 {
-	UObjectTags_Subsystem::RemoveListenerForObject(this, ObjectToTrack);
+	UObjectTags_Subsystem::UnsubscribeFromObject(ObjectToTrack, SubscriptionHandle);
+	SubscriptionHandle.Reset();
 }
 
-void UAsync_ListenForTagUpdate::ListeningObjectTagsUpdated_Implementation(FGameplayTag Tag,
-                                                                          ETagModification Modification, UObject* Object, UObject* Modifier, float NewValue, float Duration)
+void UAsync_ListenForTagUpdate::OnTrackedTagChanged(FGameplayTag Tag, ETagModification Modification, UObject* Object,
+	UObject* Modifier, float NewValue, float Duration)
 {
-	if(Tag == TagToTrack)
-	{
-		OnTagUpdate.Broadcast(Tag, Modification, Object, Modifier, NewValue, Duration);
-	}
+	OnTagUpdate.Broadcast(Tag, Modification, Object, Modifier, NewValue, Duration);
 }
@@ -5,3 +5,31 @@
 
 
 // Add default functionality here for any II_ObjectTagsCommunication functions that are not pure virtual.
+
+void II_ObjectTagsCommunication::OwningTagsBatchUpdated_Implementation(const FObjectTagsDelta& Delta, UObject* Modifier)
+{
+	UObject* Self = _getUObject();
+	for(const FGameplayTag& CurrentTag : Delta.AddedTags)
+	{
+		Execute_OwningTagsUpdated(Self, CurrentTag, Added, Modifier, Delta.Value, Delta.Duration);
+	}
+
+	for(const FGameplayTag& CurrentTag : Delta.RemovedTags)
+	{
+		Execute_OwningTagsUpdated(Self, CurrentTag, Removed, Modifier, 0, 0);
+	}
+}
+
+void II_ObjectTagsCommunication::ListeningObjectTagsBatchUpdated_Implementation(const FObjectTagsDelta& Delta, UObject* Object, UObject* Modifier)
+{
+	UObject* Self = _getUObject();
+	for(const FGameplayTag& CurrentTag : Delta.AddedTags)
+	{
+		Execute_ListeningObjectTagsUpdated(Self, CurrentTag, Added, Object, Modifier, Delta.Value, Delta.Duration);
+	}
+
+	for(const FGameplayTag& CurrentTag : Delta.RemovedTags)
+	{
+		Execute_ListeningObjectTagsUpdated(Self, CurrentTag, Removed, Object, Modifier, 0, 0);
+	}
+}
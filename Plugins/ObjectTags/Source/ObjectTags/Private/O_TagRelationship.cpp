@@ -2,3 +2,15 @@
 
 
 #include "O_TagRelationship.h"
+
+#include "ObjectTags_RelationshipIndex.h"
+
+#if WITH_EDITOR
+void UO_TagRelationship::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	//The relationship index flattened the old values, rebuild it as relationships are used.
+	FObjectTagRelationshipIndex::Get().Reset();
+}
+#endif
@@ -1,11 +1,39 @@
 ﻿// Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "ObjectTags.h"
+#include "ObjectTags_Benchmark.h"
 #include "ObjectTags_Subsystem.h"
+#include "Algo/Sort.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
 #include "Kismet/KismetSystemLibrary.h"
 
 #define LOCTEXT_NAMESPACE "FObjectTagsModule"
 
+static TAutoConsoleVariable<float> CVarDebuggerMaxDistance(
+	TEXT("ObjectTags.Debugger.MaxDistance"),
+	5000,
+	TEXT("Actors further away from the camera than this are not shown by ToggleViewActorTags. 0 means no limit."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarDebuggerMaxLabels(
+	TEXT("ObjectTags.Debugger.MaxLabels"),
+	64,
+	TEXT("Maximum amount of labels ToggleViewActorTags draws per frame, the closest actors are kept. 0 means no limit."),
+	ECVF_Default);
+
+/**Widens the view cone a bit, so labels don't pop
+ * when their actor is just at the edge of the screen.*/
+static constexpr float DebuggerFOVPadding = 1.2f;
+
+/**How often the debugger walks every tracked object for actors near the view.
+ * Actors that get their first tag or move into range show up within this.*/
+static constexpr double DebuggerGatherInterval = 0.25;
+
+/**Candidates are gathered this much further out than MaxDistance,
+ * so the view can move this far before they have to be gathered again.*/
+static constexpr float DebuggerGatherMargin = 0.25f;
+
 void FObjectTagsModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
@@ -18,12 +46,31 @@ void FObjectTagsModule::StartupModule()
 				if(TickDelegateHandle.IsValid())
 				{
 					FTSTicker::GetCoreTicker().RemoveTicker(TickDelegateHandle);
+					TickDelegateHandle.Reset();
+					DebugLabels.Empty();
+					DebugCandidates.Empty();
+					NextDebugCandidatesTime = 0;
 				}
 				else
 				{
 					TickDelegateHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FObjectTagsModule::Tick));
 				}
 			}));
+
+	IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("ObjectTags.Benchmark.Query"),
+			TEXT("ObjectTags.Benchmark.Query [Objects] [Iterations]. Compare reading tags through GetObjectTags copies against the FindObjectTags view."),
+			FConsoleCommandWithArgsDelegate::CreateStatic(&FObjectTagsBenchmark::RunQueryBenchmark));
+
+	IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("ObjectTags.Benchmark.SaveLoad"),
+			TEXT("ObjectTags.Benchmark.SaveLoad [Objects] [Iterations]. Time saving and loading the compact tag save format."),
+			FConsoleCommandWithArgsDelegate::CreateStatic(&FObjectTagsBenchmark::RunSaveLoadBenchmark));
+
+	IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("ObjectTags.Benchmark.Stress"),
+			TEXT("ObjectTags.Benchmark.Stress [Objects] [Iterations]. Time every subsystem workload at 1k, 10k and 100k objects, or only at [Objects]."),
+			FConsoleCommandWithArgsDelegate::CreateStatic(&FObjectTagsBenchmark::RunStressBenchmark));
 }
 
 void FObjectTagsModule::ShutdownModule()
@@ -34,60 +81,170 @@ void FObjectTagsModule::ShutdownModule()
 
 bool FObjectTagsModule::Tick(float DeltaTime)
 {
-	UObjectTags_Subsystem* Tags_Subsystem = UObjectTags_Subsystem::Get();
-	if(!Tags_Subsystem)
+	TRACE_CPUPROFILER_EVENT_SCOPE(ObjectTagsDebugger)
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	const TMap<TObjectPtr<UObject>, FObjectTagEntry>* AllObjectTags = UObjectTags_Subsystem::GetAllObjectTags();
+	if(!ObjectTags_Subsystem || !AllObjectTags)
 	{
+		DebugLabels.Empty();
+		DebugCandidates.Empty();
+		NextDebugCandidatesTime = 0;
 		return false;
 	}
 
-	for(auto& CurrentObject : Tags_Subsystem->ObjectTags)
+	UWorld* World = ObjectTags_Subsystem->GetWorld();
+	APlayerController* LocalController = World ? World->GetFirstPlayerController() : nullptr;
+	if(!LocalController)
+	{
+		return true;
+	}
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	LocalController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	const FVector ViewDirection = ViewRotation.Vector();
+
+	//Cone around the view direction, wide enough to cover the corners of the screen.
+	const float FOV = LocalController->PlayerCameraManager ? LocalController->PlayerCameraManager->GetFOVAngle() : 90;
+	const float CosHalfFOV = FMath::Cos(FMath::DegreesToRadians(FMath::Min(FOV * 0.5f * DebuggerFOVPadding, 89.f)));
+	const float MaxDistance = CVarDebuggerMaxDistance.GetValueOnGameThread();
+	const float MaxDistanceSquared = MaxDistance > 0 ? FMath::Square(MaxDistance) : MAX_flt;
+
+	//Only walk every tracked object every so often, or once the view left the area the candidates cover.
+	const float GatherMargin = MaxDistance * DebuggerGatherMargin;
+	const double CurrentTime = FPlatformTime::Seconds();
+	if(CurrentTime >= NextDebugCandidatesTime || DebugCandidatesWorld.Get() != World
+		|| (MaxDistance > 0 && FVector::DistSquared(ViewLocation, DebugCandidatesLocation) > FMath::Square(GatherMargin)))
+	{
+		GatherDebugCandidates(*AllObjectTags, World, ViewLocation, MaxDistance > 0 ? MaxDistance + GatherMargin : 0);
+		NextDebugCandidatesTime = CurrentTime + DebuggerGatherInterval;
+	}
+
+	//Gather the visible actors first, so the label cap keeps the closest ones.
+	TArray<TPair<float, const FObjectTagEntry*>, TInlineAllocator<64>> VisibleObjects;
+	for(const TWeakObjectPtr<AActor>& Candidate : DebugCandidates)
 	{
-		if(AActor* Actor = Cast<AActor>(CurrentObject.Key))
+		AActor* Actor = Candidate.Get();
+		const FObjectTagEntry* ObjectTag = Actor ? UObjectTags_Subsystem::FindObjectTags(Actor) : nullptr;
+		if(!ObjectTag || !ObjectTag->HasAnyTags())
 		{
-			if(APawn* Pawn = Cast<APawn>(Actor))
-			{
-				//This will skip the players pawn
-				if(Pawn->IsPawnControlled())
-				{
-					if(Pawn->Controller->IsLocalPlayerController())
-					{
-						continue;
-					}
-				}
-			}
-			
-			if(APlayerController* Controller = Cast<APlayerController>(Actor))
-			{
-				//We are never interested in the controller
-				continue;
-			}
-			
-			FVector ActorCenter;
-			FVector ActorBounds;
-			Actor->GetActorBounds(true, ActorCenter, ActorBounds);
-			FString Text;
-
-			for(auto& CurrentTag : CurrentObject.Value.TagsAndValues)
-			{
-				if(!Text.IsEmpty())
-				{
-					Text += "\n";
-				}
-				
-				Text += CurrentTag.Key.ToString() + " - " + FString::SanitizeFloat(CurrentTag.Value);
-				if(CurrentObject.Value.TagTimers.Contains(CurrentTag.Key))
-				{
-					Text += " : " + FString::SanitizeFloat(UKismetSystemLibrary::K2_GetTimerRemainingTimeHandle(Actor, *CurrentObject.Value.TagTimers.Find(CurrentTag.Key)));
-				}
-			}
-			
-			DrawDebugString(Actor->GetWorld(), ActorCenter - Actor->GetActorLocation() + FVector(0, 20, 40), Text, Actor, FColor::White, 0, true);
+			continue;
+		}
+
+		//We are never interested in the controller or the local players pawn
+		if(Actor == LocalController->GetPawn())
+		{
+			continue;
+		}
+
+		const FVector ToActor = Actor->GetActorLocation() - ViewLocation;
+		const float DistanceSquared = ToActor.SizeSquared();
+		if(DistanceSquared > MaxDistanceSquared)
+		{
+			continue;
+		}
+
+		//Skip anything behind or to the side of the camera. Actors right
+		//on top of the camera are always kept, their direction is meaningless.
+		if(DistanceSquared > 1 && (ToActor | ViewDirection) < CosHalfFOV * FMath::Sqrt(DistanceSquared))
+		{
+			continue;
+		}
+
+		VisibleObjects.Emplace(DistanceSquared, ObjectTag);
+	}
+
+	const int32 MaxLabels = CVarDebuggerMaxLabels.GetValueOnGameThread();
+	if(MaxLabels > 0 && VisibleObjects.Num() > MaxLabels)
+	{
+		Algo::Sort(VisibleObjects, [](const TPair<float, const FObjectTagEntry*>& A, const TPair<float, const FObjectTagEntry*>& B)
+		{
+			return A.Key < B.Key;
+		});
+		VisibleObjects.SetNum(MaxLabels, EAllowShrinking::No);
+	}
+
+	for(const TPair<float, const FObjectTagEntry*>& CurrentObject : VisibleObjects)
+	{
+		const FObjectTagEntry& ObjectTag = *CurrentObject.Value;
+		AActor* Actor = CastChecked<AActor>(ObjectTag.Object);
+		FObjectTagDebugLabel& Label = DebugLabels.FindOrAdd(Actor);
+		Label.DrawnFrame = GFrameCounter;
+
+		//Only rebuild the text when the tags changed, or when a timer is counting down.
+		if(Label.Text.IsEmpty() || Label.Revision != ObjectTag.Revision || Label.bHasTimers)
+		{
+			RebuildDebugLabel(Label, ObjectTag, Actor);
+		}
+
+		DrawDebugString(Actor->GetWorld(), Label.Offset, Label.Text, Actor, FColor::White, 0, true);
+	}
+
+	//Labels that weren't drawn belong to actors that went out of view or lost their entry.
+	for(TMap<FObjectKey, FObjectTagDebugLabel>::TIterator It = DebugLabels.CreateIterator(); It; ++It)
+	{
+		if(It.Value().DrawnFrame != GFrameCounter)
+		{
+			It.RemoveCurrent();
 		}
 	}
 	
 	return true;
 }
 
+void FObjectTagsModule::GatherDebugCandidates(const TMap<TObjectPtr<UObject>, FObjectTagEntry>& AllObjectTags, UWorld* World, const FVector& ViewLocation, float GatherDistance)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(GatherDebugCandidates)
+	DebugCandidates.Reset();
+	DebugCandidatesWorld = World;
+	DebugCandidatesLocation = ViewLocation;
+
+	const float GatherDistanceSquared = GatherDistance > 0 ? FMath::Square(GatherDistance) : MAX_flt;
+	for(const TPair<TObjectPtr<UObject>, FObjectTagEntry>& CurrentObject : AllObjectTags)
+	{
+		AActor* Actor = Cast<AActor>(CurrentObject.Key);
+		if(!Actor || Actor->GetWorld() != World || !CurrentObject.Value.HasAnyTags() || Actor->IsA<APlayerController>())
+		{
+			continue;
+		}
+
+		if(FVector::DistSquared(Actor->GetActorLocation(), ViewLocation) <= GatherDistanceSquared)
+		{
+			DebugCandidates.Add(Actor);
+		}
+	}
+}
+
+void FObjectTagsModule::RebuildDebugLabel(FObjectTagDebugLabel& Label, const FObjectTagEntry& ObjectTag, AActor* Actor)
+{
+	//Bounds only need to be refreshed with the text, the label is attached to the actor.
+	FVector ActorCenter;
+	FVector ActorBounds;
+	Actor->GetActorBounds(true, ActorCenter, ActorBounds);
+	Label.Offset = ActorCenter - Actor->GetActorLocation() + FVector(0, 20, 40);
+	Label.Revision = ObjectTag.Revision;
+	Label.bHasTimers = false;
+	Label.Text.Reset();
+
+	const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	for(int32 CurrentSlot = 0; CurrentSlot < ObjectTag.NumTags(); CurrentSlot++)
+	{
+		if(!Label.Text.IsEmpty())
+		{
+			Label.Text += TEXT("\n");
+		}
+
+		const FGameplayTag CurrentTag = IndexTable.GetTag(ObjectTag.TagIndices[CurrentSlot]);
+		Label.Text += CurrentTag.ToString() + TEXT(" - ") + FString::SanitizeFloat(ObjectTag.TagValues[CurrentSlot]);
+		const float RemainingTime = UObjectTags_Subsystem::GetTagRemainingTime(CurrentTag, Actor);
+		if(RemainingTime >= 0)
+		{
+			Label.Text += TEXT(" : ") + FString::SanitizeFloat(RemainingTime);
+			Label.bHasTimers = true;
+		}
+	}
+}
+
 #undef LOCTEXT_NAMESPACE
 	
 IMPLEMENT_MODULE(FObjectTagsModule, ObjectTags)
\ No newline at end of file
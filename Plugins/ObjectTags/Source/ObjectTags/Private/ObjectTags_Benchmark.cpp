@@ -0,0 +1,415 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+
+#include "ObjectTags_Benchmark.h"
+
+#include "GameplayTagsManager.h"
+#include "O_TagRelationship.h"
+#include "ObjectTags_Subsystem.h"
+#include "UObject/UObjectIterator.h"
+
+DEFINE_LOG_CATEGORY_STATIC(ObjectTagsBenchmarkLog, Log, All)
+
+void FObjectTagsBenchmark::RunQueryBenchmark(const TArray<FString>& Args)
+{
+	const int32 ObjectCount = Args.IsValidIndex(0) ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+	const int32 Iterations = Args.IsValidIndex(1) ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 100;
+
+	if(!UObjectTags_Subsystem::Get())
+	{
+		UE_LOG(ObjectTagsBenchmarkLog, Warning, TEXT("ObjectTags benchmark needs a running game instance"));
+		return;
+	}
+
+	const TArray<FGameplayTag> Tags = GetBenchmarkTags(8);
+	if(Tags.IsEmpty())
+	{
+		UE_LOG(ObjectTagsBenchmarkLog, Warning, TEXT("ObjectTags benchmark found no gameplay tags to use"));
+		return;
+	}
+
+	const TArray<UObject*> Objects = PopulateObjects(ObjectCount, Tags);
+	const FGameplayTagQuery TagQuery = FGameplayTagQuery::MakeQuery_MatchAnyTags(FGameplayTagContainer(Tags.Last()));
+	const double Operations = static_cast<double>(ObjectCount) * Iterations;
+
+	//Used so the compiler can't throw the work away.
+	int32 Matches = 0;
+	float ValueSum = 0;
+
+	double StartTime = FPlatformTime::Seconds();
+	for(int32 CurrentIteration = 0; CurrentIteration < Iterations; CurrentIteration++)
+	{
+		for(UObject* CurrentObject : Objects)
+		{
+			const FObjectTag ObjectTag = UObjectTags_Subsystem::GetObjectTags(CurrentObject);
+			Matches += TagQuery.Matches(ObjectTag.GetTagsAsContainer());
+		}
+	}
+	const double CopyQueryTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for(int32 CurrentIteration = 0; CurrentIteration < Iterations; CurrentIteration++)
+	{
+		for(UObject* CurrentObject : Objects)
+		{
+			const FObjectTagEntry* ObjectTag = UObjectTags_Subsystem::FindObjectTags(CurrentObject);
+			Matches += TagQuery.Matches(ObjectTag ? ObjectTag->GetCachedTagsContainer() : FGameplayTagContainer::EmptyContainer);
+		}
+	}
+	const double ViewQueryTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for(int32 CurrentIteration = 0; CurrentIteration < Iterations; CurrentIteration++)
+	{
+		for(UObject* CurrentObject : Objects)
+		{
+			const FObjectTag ObjectTag = UObjectTags_Subsystem::GetObjectTags(CurrentObject);
+			if(const float* Value = ObjectTag.FindValue(Tags[0]))
+			{
+				ValueSum += *Value;
+			}
+		}
+	}
+	const double CopyValueTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for(int32 CurrentIteration = 0; CurrentIteration < Iterations; CurrentIteration++)
+	{
+		for(UObject* CurrentObject : Objects)
+		{
+			const FObjectTagEntry* ObjectTag = UObjectTags_Subsystem::FindObjectTags(CurrentObject);
+			if(const float* Value = ObjectTag ? ObjectTag->FindValue(Tags[0]) : nullptr)
+			{
+				ValueSum += *Value;
+			}
+		}
+	}
+	const double ViewValueTime = FPlatformTime::Seconds() - StartTime;
+
+	CleanupObjects(Objects, Tags);
+
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("ObjectTags query benchmark: %d objects, %d tags each, %d iterations (%d matches, %f sum)"),
+		ObjectCount, Tags.Num(), Iterations, Matches, ValueSum);
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Tag query   - copy: %8.1f ns/op, view: %8.1f ns/op"),
+		CopyQueryTime * 1e9 / Operations, ViewQueryTime * 1e9 / Operations);
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Value query - copy: %8.1f ns/op, view: %8.1f ns/op"),
+		CopyValueTime * 1e9 / Operations, ViewValueTime * 1e9 / Operations);
+}
+
+void FObjectTagsBenchmark::RunSaveLoadBenchmark(const TArray<FString>& Args)
+{
+	const int32 ObjectCount = Args.IsValidIndex(0) ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+	const int32 Iterations = Args.IsValidIndex(1) ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 10;
+
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem)
+	{
+		UE_LOG(ObjectTagsBenchmarkLog, Warning, TEXT("ObjectTags benchmark needs a running game instance"));
+		return;
+	}
+
+	const TArray<FGameplayTag> Tags = GetBenchmarkTags(8);
+	if(Tags.IsEmpty())
+	{
+		UE_LOG(ObjectTagsBenchmarkLog, Warning, TEXT("ObjectTags benchmark found no gameplay tags to use"));
+		return;
+	}
+
+	TArray<uint8> OriginalState;
+	ObjectTags_Subsystem->SaveTagState(OriginalState);
+
+	//Transient objects have no stable path and would be skipped by the save.
+	const TArray<UObject*> Objects = PopulateObjects(ObjectCount, Tags, true);
+
+	//Give every other object a temporary tag with its own value, so durations and values are part of the save.
+	for(int32 CurrentObject = 0; CurrentObject < Objects.Num(); CurrentObject += 2)
+	{
+		UObjectTags_Subsystem::AddTagToObject(Tags[0], Objects[CurrentObject], nullptr, CurrentObject, 60);
+	}
+
+	TArray<uint8> SaveData;
+	int32 SavedObjects = 0;
+	double StartTime = FPlatformTime::Seconds();
+	for(int32 CurrentIteration = 0; CurrentIteration < Iterations; CurrentIteration++)
+	{
+		SavedObjects = ObjectTags_Subsystem->SaveTagState(SaveData);
+	}
+	const double SaveTime = (FPlatformTime::Seconds() - StartTime) / Iterations;
+
+	if(SavedObjects < ObjectCount)
+	{
+		CleanupObjects(Objects, Tags);
+		ObjectTags_Subsystem->LoadTagState(OriginalState);
+		UE_LOG(ObjectTagsBenchmarkLog, Error, TEXT("ObjectTags save benchmark failed, only %d of the %d benchmark objects were saved"),
+			SavedObjects, ObjectCount);
+		return;
+	}
+
+	bool bLoaded = true;
+	StartTime = FPlatformTime::Seconds();
+	for(int32 CurrentIteration = 0; CurrentIteration < Iterations; CurrentIteration++)
+	{
+		bLoaded &= ObjectTags_Subsystem->LoadTagState(SaveData);
+	}
+	const double LoadTime = (FPlatformTime::Seconds() - StartTime) / Iterations;
+
+	CleanupObjects(Objects, Tags);
+	ObjectTags_Subsystem->LoadTagState(OriginalState);
+
+	if(!bLoaded)
+	{
+		UE_LOG(ObjectTagsBenchmarkLog, Error, TEXT("ObjectTags save benchmark failed, LoadTagState rejected its own save"));
+		return;
+	}
+
+	//The save also holds whatever was tagged before the benchmark, so everything is per saved object.
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("ObjectTags save benchmark: %d objects (%d saved), %d tags each, %d iterations"),
+		ObjectCount, SavedObjects, Tags.Num(), Iterations);
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Size: %d bytes, %.1f bytes per object"),
+		SaveData.Num(), static_cast<double>(SaveData.Num()) / SavedObjects);
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Save: %8.3f ms, %8.1f ns per object"),
+		SaveTime * 1e3, SaveTime * 1e9 / SavedObjects);
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Load: %8.3f ms, %8.1f ns per object"),
+		LoadTime * 1e3, LoadTime * 1e9 / SavedObjects);
+}
+
+void FObjectTagsBenchmark::RunStressBenchmark(const TArray<FString>& Args)
+{
+	const int32 Iterations = Args.IsValidIndex(1) ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 10;
+
+	if(!UObjectTags_Subsystem::Get())
+	{
+		UE_LOG(ObjectTagsBenchmarkLog, Warning, TEXT("ObjectTags benchmark needs a running game instance"));
+		return;
+	}
+
+	const TArray<FGameplayTag> Tags = GetBenchmarkTags(8);
+	if(Tags.IsEmpty())
+	{
+		UE_LOG(ObjectTagsBenchmarkLog, Warning, TEXT("ObjectTags benchmark found no gameplay tags to use"));
+		return;
+	}
+
+	if(Args.IsValidIndex(0))
+	{
+		RunStressWorkloads(FMath::Max(FCString::Atoi(*Args[0]), 1), Iterations, Tags);
+		return;
+	}
+
+	for(const int32 ObjectCount : {1000, 10000, 100000})
+	{
+		RunStressWorkloads(ObjectCount, Iterations, Tags);
+	}
+}
+
+void FObjectTagsBenchmark::RunStressWorkloads(int32 ObjectCount, int32 Iterations, const TArray<FGameplayTag>& Tags)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	const double TagOperations = static_cast<double>(ObjectCount) * Tags.Num();
+
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("ObjectTags stress benchmark: %d objects, %d tags each, %d query iterations"),
+		ObjectCount, Tags.Num(), Iterations);
+
+	TArray<UObject*> Objects;
+	Objects.Reserve(ObjectCount);
+	for(int32 CurrentObject = 0; CurrentObject < ObjectCount; CurrentObject++)
+	{
+		Objects.Add(NewObject<UObject>(GetTransientPackage(), UObject::StaticClass(), NAME_None, RF_Transient));
+	}
+
+	const SIZE_T MapBytesBefore = ObjectTags_Subsystem->ObjectTags.GetAllocatedSize();
+
+	//Add, one tag at a time so every add goes through the full single tag path.
+	double StartTime = FPlatformTime::Seconds();
+	for(UObject* CurrentObject : Objects)
+	{
+		for(const FGameplayTag& CurrentTag : Tags)
+		{
+			UObjectTags_Subsystem::AddTagToObject(CurrentTag, CurrentObject, nullptr);
+		}
+	}
+	const double AddTime = FPlatformTime::Seconds() - StartTime;
+
+	//Memory, only counting the entries this benchmark created.
+	SIZE_T TagStorageBytes = 0;
+	for(UObject* CurrentObject : Objects)
+	{
+		if(const FObjectTagEntry* ObjectTag = UObjectTags_Subsystem::FindObjectTags(CurrentObject))
+		{
+			TagStorageBytes += ObjectTag->GetTagStorageAllocatedSize();
+		}
+	}
+	const SIZE_T MapBytes = ObjectTags_Subsystem->ObjectTags.GetAllocatedSize() - FMath::Min(MapBytesBefore, ObjectTags_Subsystem->ObjectTags.GetAllocatedSize());
+
+	//Query
+	int32 Matches = 0;
+	StartTime = FPlatformTime::Seconds();
+	for(int32 CurrentIteration = 0; CurrentIteration < Iterations; CurrentIteration++)
+	{
+		for(UObject* CurrentObject : Objects)
+		{
+			for(const FGameplayTag& CurrentTag : Tags)
+			{
+				Matches += UObjectTags_Subsystem::DoesObjectHaveTag(CurrentTag, CurrentObject);
+			}
+		}
+	}
+	const double QueryTime = FPlatformTime::Seconds() - StartTime;
+
+	//Listener broadcast, every object has one subscriber to the first tag that gets told about it being removed and re-added.
+	int32 Broadcasts = 0;
+	TArray<FDelegateHandle> Handles;
+	Handles.Reserve(ObjectCount);
+	for(UObject* CurrentObject : Objects)
+	{
+		Handles.Add(UObjectTags_Subsystem::SubscribeToTag(CurrentObject, Tags[0], FOnObjectTagChanged::CreateLambda(
+			[&Broadcasts](FGameplayTag, ETagModification, UObject*, UObject*, float, float)
+			{
+				Broadcasts++;
+			})));
+	}
+
+	const FGameplayTagContainer FirstTag(Tags[0]);
+	StartTime = FPlatformTime::Seconds();
+	for(UObject* CurrentObject : Objects)
+	{
+		UObjectTags_Subsystem::RemoveTagsFromObject(FirstTag, CurrentObject, nullptr);
+		UObjectTags_Subsystem::AddTagToObject(Tags[0], CurrentObject, nullptr);
+	}
+	const double BroadcastTime = FPlatformTime::Seconds() - StartTime;
+
+	for(int32 CurrentObject = 0; CurrentObject < ObjectCount; CurrentObject++)
+	{
+		UObjectTags_Subsystem::UnsubscribeFromObject(Objects[CurrentObject], Handles[CurrentObject]);
+	}
+
+	//Remove, one tag at a time like the add.
+	TArray<FGameplayTagContainer> SingleTags;
+	for(const FGameplayTag& CurrentTag : Tags)
+	{
+		SingleTags.Emplace(CurrentTag);
+	}
+	
+	StartTime = FPlatformTime::Seconds();
+	for(UObject* CurrentObject : Objects)
+	{
+		for(const FGameplayTagContainer& CurrentTag : SingleTags)
+		{
+			UObjectTags_Subsystem::RemoveTagsFromObject(CurrentTag, CurrentObject, nullptr);
+		}
+	}
+	const double RemoveTime = FPlatformTime::Seconds() - StartTime;
+
+	//Relationships, only if the project has one loaded.
+	double RelationshipTime = -1;
+	if(const TSubclassOf<UO_TagRelationship> Relationship = FindBenchmarkRelationship())
+	{
+		StartTime = FPlatformTime::Seconds();
+		for(UObject* CurrentObject : Objects)
+		{
+			UObjectTags_Subsystem::AddTagToObjectWithRelationship(Relationship, CurrentObject, nullptr);
+		}
+		RelationshipTime = FPlatformTime::Seconds() - StartTime;
+
+		CleanupObjects(Objects, {Relationship.GetDefaultObject()->Tag});
+	}
+
+	//Stale entry cleanup, every object is tagged again and then destroyed.
+	UObjectTags_Subsystem::AddTagsToObjects(FGameplayTagContainer::CreateFromArray(Tags), Objects, nullptr);
+	for(UObject* CurrentObject : Objects)
+	{
+		CurrentObject->MarkAsGarbage();
+	}
+
+	const int32 EntriesBefore = ObjectTags_Subsystem->ObjectTags.Num();
+	StartTime = FPlatformTime::Seconds();
+	ObjectTags_Subsystem->SweepStaleObjects(ObjectTags_Subsystem->ObjectTags.GetMaxIndex());
+	const double SweepTime = FPlatformTime::Seconds() - StartTime;
+	const int32 EntriesReclaimed = EntriesBefore - ObjectTags_Subsystem->ObjectTags.Num();
+
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Add:          %8.1f ns/op"), AddTime * 1e9 / TagOperations);
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Query:        %8.1f ns/op (%d matches)"),
+		QueryTime * 1e9 / (TagOperations * Iterations), Matches);
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Broadcast:    %8.1f ns/op (%d notifications)"),
+		BroadcastTime * 1e9 / (2.0 * ObjectCount), Broadcasts);
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Remove:       %8.1f ns/op"), RemoveTime * 1e9 / TagOperations);
+	if(RelationshipTime >= 0)
+	{
+		UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Relationship: %8.1f ns/op"), RelationshipTime * 1e9 / ObjectCount);
+	}
+	else
+	{
+		UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Relationship: skipped, no tag relationship class is loaded"));
+	}
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Cleanup:      %8.1f ns/op (%d entries reclaimed)"),
+		SweepTime * 1e9 / ObjectCount, EntriesReclaimed);
+	UE_LOG(ObjectTagsBenchmarkLog, Display, TEXT("  Memory:       %.1f bytes per object (%.1f map, %.1f tag storage)"),
+		static_cast<double>(MapBytes + TagStorageBytes) / ObjectCount,
+		static_cast<double>(MapBytes) / ObjectCount, static_cast<double>(TagStorageBytes) / ObjectCount);
+}
+
+TSubclassOf<UO_TagRelationship> FObjectTagsBenchmark::FindBenchmarkRelationship()
+{
+	for(TObjectIterator<UClass> It; It; ++It)
+	{
+		if(It->IsChildOf(UO_TagRelationship::StaticClass()) && !It->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists))
+		{
+			if(It->GetDefaultObject<UO_TagRelationship>()->Tag.IsValid())
+			{
+				return *It;
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+TArray<FGameplayTag> FObjectTagsBenchmark::GetBenchmarkTags(int32 Count)
+{
+	FGameplayTagContainer AllTags;
+	UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, true);
+
+	TArray<FGameplayTag> Tags;
+	for(const FGameplayTag& CurrentTag : AllTags)
+	{
+		if(Tags.Num() >= Count)
+		{
+			break;
+		}
+		Tags.Add(CurrentTag);
+	}
+
+	return Tags;
+}
+
+TArray<UObject*> FObjectTagsBenchmark::PopulateObjects(int32 Count, const TArray<FGameplayTag>& Tags, bool bStablePaths)
+{
+	TArray<UObject*> Objects;
+	Objects.Reserve(Count);
+	if(bStablePaths)
+	{
+		//Public objects directly inside a non transient package count as assets,
+		//so they can be found by path again. The package is never saved to disk.
+		UPackage* Package = CreatePackage(TEXT("/Temp/ObjectTagsBenchmark"));
+		for(int32 CurrentObject = 0; CurrentObject < Count; CurrentObject++)
+		{
+			const FName ObjectName = MakeUniqueObjectName(Package, UObject::StaticClass(), TEXT("BenchmarkObject"));
+			Objects.Add(NewObject<UObject>(Package, UObject::StaticClass(), ObjectName, RF_Public));
+		}
+	}
+	else
+	{
+		for(int32 CurrentObject = 0; CurrentObject < Count; CurrentObject++)
+		{
+			Objects.Add(NewObject<UObject>(GetTransientPackage(), UObject::StaticClass(), NAME_None, RF_Transient));
+		}
+	}
+
+	UObjectTags_Subsystem::AddTagsToObjects(FGameplayTagContainer::CreateFromArray(Tags), Objects, nullptr);
+	return Objects;
+}
+
+void FObjectTagsBenchmark::CleanupObjects(const TArray<UObject*>& Objects, const TArray<FGameplayTag>& Tags)
+{
+	UObjectTags_Subsystem::RemoveTagsFromObjects(FGameplayTagContainer::CreateFromArray(Tags), Objects, nullptr);
+}
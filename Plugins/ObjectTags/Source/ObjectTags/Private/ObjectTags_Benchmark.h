@@ -0,0 +1,54 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+class UO_TagRelationship;
+
+/**Console driven benchmarks for the object tags subsystem.
+ * Results are printed to the log in nanoseconds per operation.*/
+class FObjectTagsBenchmark
+{
+public:
+
+	/**ObjectTags.Benchmark.Query [Objects] [Iterations]
+	 * Compares reading tags through a GetObjectTags copy against
+	 * the FindObjectTags view, the way the StateTree conditions do.*/
+	static void RunQueryBenchmark(const TArray<FString>& Args);
+
+	/**ObjectTags.Benchmark.SaveLoad [Objects] [Iterations]
+	 * Times SaveTagState and LoadTagState and reports the save size.
+	 * Fails if the save doesn't contain every benchmark object.
+	 * The current tag state is saved first and restored afterwards,
+	 * anything that can't be found by path again is lost.*/
+	static void RunSaveLoadBenchmark(const TArray<FString>& Args);
+
+	/**ObjectTags.Benchmark.Stress [Objects] [Iterations]
+	 * Runs the add, query, remove, listener broadcast, relationship and
+	 * stale entry cleanup workloads at 1k, 10k and 100k objects, or only
+	 * at [Objects] if given, and reports ns/op and memory per object.
+	 * Can be run headless, for example:
+	 * -game -nullrhi -unattended -ExecCmds="ObjectTags.Benchmark.Stress, Quit"*/
+	static void RunStressBenchmark(const TArray<FString>& Args);
+
+private:
+
+	/**Run every stress workload once with @ObjectCount objects.*/
+	static void RunStressWorkloads(int32 ObjectCount, int32 Iterations, const TArray<FGameplayTag>& Tags);
+
+	/**First loaded tag relationship class with a base tag, or null if there is none.*/
+	static TSubclassOf<UO_TagRelationship> FindBenchmarkRelationship();
+
+	/**Get up to @Count registered gameplay tags to benchmark with.*/
+	static TArray<FGameplayTag> GetBenchmarkTags(int32 Count);
+
+	/**Create @Count objects and give each of them all the @Tags.
+	 * They are transient, unless @bStablePaths is set, in which case they
+	 * are named objects in a temporary package so the save can find them again.*/
+	static TArray<UObject*> PopulateObjects(int32 Count, const TArray<FGameplayTag>& Tags, bool bStablePaths = false);
+
+	/**Remove every tag from the @Objects so the subsystem stops tracking them.*/
+	static void CleanupObjects(const TArray<UObject*>& Objects, const TArray<FGameplayTag>& Tags);
+};
@@ -0,0 +1,127 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+
+#include "ObjectTags_ExpiryScheduler.h"
+
+FObjectTagExpiryScheduler::FObjectTagExpiryScheduler(int32 SlotCount, double InSlotDuration)
+	: SlotDuration(InSlotDuration)
+{
+	check(SlotCount > 0 && SlotDuration > 0);
+	Slots.SetNum(SlotCount);
+}
+
+void FObjectTagExpiryScheduler::Schedule(UObject* Object, uint16 TagIndex, UObject* Modifier, double Duration)
+{
+	const FEntryKey Key(Object, TagIndex);
+	
+	int32 EntryId;
+	if(const int32* FoundId = EntryLookup.Find(Key))
+	{
+		//Refreshing, the old slot reference becomes stale and gets dropped when that slot is visited.
+		EntryId = *FoundId;
+	}
+	else
+	{
+		EntryId = Entries.Add(FEntry());
+		EntryLookup.Add(Key, EntryId);
+	}
+
+	FEntry& Entry = Entries[EntryId];
+	Entry.Object = Object;
+	Entry.Modifier = Modifier;
+	Entry.TagIndex = TagIndex;
+	Entry.ExpiryTime = CurrentTime + Duration;
+	Entry.Sequence = NextSequence++;
+
+	Slots[GetSlotForExpiry(Entry.ExpiryTime)].Add({EntryId, Entry.Sequence});
+}
+
+void FObjectTagExpiryScheduler::Cancel(const UObject* Object, uint16 TagIndex)
+{
+	int32 EntryId;
+	if(EntryLookup.RemoveAndCopyValue(FEntryKey(Object, TagIndex), EntryId))
+	{
+		Entries.RemoveAt(EntryId);
+	}
+}
+
+void FObjectTagExpiryScheduler::CancelObject(const TWeakObjectPtr<UObject>& Object, TConstArrayView<uint16> TagIndices)
+{
+	for(const uint16 TagIndex : TagIndices)
+	{
+		int32 EntryId;
+		if(EntryLookup.RemoveAndCopyValue(FEntryKey(Object, TagIndex), EntryId))
+		{
+			Entries.RemoveAt(EntryId);
+		}
+	}
+}
+
+bool FObjectTagExpiryScheduler::IsScheduled(const UObject* Object, uint16 TagIndex) const
+{
+	return EntryLookup.Contains(FEntryKey(Object, TagIndex));
+}
+
+double FObjectTagExpiryScheduler::GetRemainingTime(const UObject* Object, uint16 TagIndex) const
+{
+	if(const int32* FoundId = EntryLookup.Find(FEntryKey(Object, TagIndex)))
+	{
+		return FMath::Max(Entries[*FoundId].ExpiryTime - CurrentTime, 0.0);
+	}
+
+	return -1;
+}
+
+void FObjectTagExpiryScheduler::Advance(double DeltaTime, TArray<FExpiredTag>& OutExpiredTags)
+{
+	CurrentTime += DeltaTime;
+	const int64 TargetTick = FMath::FloorToInt64(CurrentTime / SlotDuration);
+
+	//Never visit a slot twice in one pass, even if we skipped more than a whole rotation.
+	const int64 LastTickToProcess = FMath::Min(TargetTick, LastProcessedTick + Slots.Num());
+	for(int64 CurrentTick = LastProcessedTick + 1; CurrentTick <= LastTickToProcess; CurrentTick++)
+	{
+		TArray<FSlotEntry>& Slot = Slots[CurrentTick % Slots.Num()];
+		
+		for(int32 CurrentSlotEntry = 0; CurrentSlotEntry < Slot.Num(); CurrentSlotEntry++)
+		{
+			const FSlotEntry SlotEntry = Slot[CurrentSlotEntry];
+			const bool bStale = !Entries.IsAllocated(SlotEntry.EntryId) || Entries[SlotEntry.EntryId].Sequence != SlotEntry.Sequence;
+			if(!bStale)
+			{
+				FEntry& Entry = Entries[SlotEntry.EntryId];
+				if(Entry.ExpiryTime > CurrentTime)
+				{
+					//More than a rotation away, wait for the next lap.
+					continue;
+				}
+
+				OutExpiredTags.Add({Entry.Object, Entry.Modifier, Entry.TagIndex});
+				EntryLookup.Remove(FEntryKey(Entry.Object, Entry.TagIndex));
+				Entries.RemoveAt(SlotEntry.EntryId);
+			}
+
+			Slot.RemoveAtSwap(CurrentSlotEntry, EAllowShrinking::No);
+			CurrentSlotEntry--;
+		}
+	}
+
+	LastProcessedTick = FMath::Max(LastProcessedTick, TargetTick);
+}
+
+void FObjectTagExpiryScheduler::Reset()
+{
+	Entries.Empty();
+	EntryLookup.Empty();
+	for(TArray<FSlotEntry>& Slot : Slots)
+	{
+		Slot.Reset();
+	}
+}
+
+int32 FObjectTagExpiryScheduler::GetSlotForExpiry(double ExpiryTime) const
+{
+	//Round up, so by the time the slot is visited the tag is guaranteed to have expired.
+	const int64 Tick = FMath::Max(FMath::CeilToInt64(ExpiryTime / SlotDuration), LastProcessedTick + 1);
+	return static_cast<int32>(Tick % Slots.Num());
+}
@@ -0,0 +1,124 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+
+#include "ObjectTags_History.h"
+
+#if OBJECTTAGS_WITH_HISTORY
+
+#include "ObjectTags_TagIndex.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(ObjectTagsHistoryLog, Log, All)
+
+FObjectTagHistoryBuffer& FObjectTagHistoryBuffer::Get()
+{
+	static FObjectTagHistoryBuffer Buffer;
+	return Buffer;
+}
+
+FObjectTagHistoryBuffer::FObjectTagHistoryBuffer(uint32 Capacity)
+	: SlotCount(FMath::RoundUpToPowerOfTwo(FMath::Max<uint32>(Capacity, 2)))
+{
+	Slots = MakeUnique<FSlot[]>(SlotCount);
+	Mask = SlotCount - 1;
+}
+
+void FObjectTagHistoryBuffer::Record(const UObject* Object, uint16 TagIndex, ETagModification Modification, const UObject* Modifier)
+{
+	const uint64 Ticket = Head.fetch_add(1);
+	FSlot& Slot = Slots[Ticket & Mask];
+
+	//Mark the slot as being written, so readers don't pick up half a record.
+	Slot.Sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	
+	Slot.Record.Object = FObjectKey(Object);
+	Slot.Record.Modifier = FObjectKey(Modifier);
+	Slot.Record.Time = FPlatformTime::Seconds();
+	Slot.Record.TagIndex = TagIndex;
+	Slot.Record.Modification = Modification;
+	
+	Slot.Sequence.store(Ticket + 1, std::memory_order_release);
+}
+
+void FObjectTagHistoryBuffer::GetRecords(TArray<FObjectTagHistoryRecord>& OutRecords, const UObject* Object) const
+{
+	const FObjectKey ObjectKey(Object);
+	const uint64 End = Head.load();
+	const uint64 Start = End > SlotCount ? End - SlotCount : 0;
+	
+	OutRecords.Reserve(OutRecords.Num() + static_cast<int32>(End - Start));
+	for(uint64 Ticket = Start; Ticket < End; Ticket++)
+	{
+		const FSlot& Slot = Slots[Ticket & Mask];
+		if(Slot.Sequence.load(std::memory_order_acquire) != Ticket + 1)
+		{
+			//Still being written or already overwritten.
+			continue;
+		}
+
+		const FObjectTagHistoryRecord Record = Slot.Record;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(Slot.Sequence.load(std::memory_order_relaxed) != Ticket + 1)
+		{
+			continue;
+		}
+
+		if(!Object || Record.Object == ObjectKey)
+		{
+			OutRecords.Add(Record);
+		}
+	}
+}
+
+FString FObjectTagHistoryBuffer::RecordToString(const FObjectTagHistoryRecord& Record)
+{
+	const UObject* Object = Record.Object.ResolveObjectPtr();
+	const UObject* Modifier = Record.Modifier.ResolveObjectPtr();
+	const TCHAR* ModificationName = Record.Modification == Added ? TEXT("Added")
+		: Record.Modification == Removed ? TEXT("Removed") : TEXT("ValueModified");
+
+	return FString::Printf(TEXT("%.3f %s %s on %s by %s"),
+		Record.Time,
+		ModificationName,
+		*FObjectTagIndexTable::Get().GetTag(Record.TagIndex).ToString(),
+		Object ? *UKismetSystemLibrary::GetDisplayName(Object) : TEXT("Destroyed Object"),
+		Modifier ? *UKismetSystemLibrary::GetDisplayName(Modifier) : TEXT("Invalid Object"));
+}
+
+void FObjectTagHistoryBuffer::DumpHistoryConsoleCommand(const TArray<FString>& Args)
+{
+	TArray<FObjectTagHistoryRecord> Records;
+	Get().GetRecords(Records);
+
+	if(!Args.IsValidIndex(0))
+	{
+		UE_LOG(ObjectTagsHistoryLog, Display, TEXT("Object tag history, %d of %llu records:"), Records.Num(), Get().GetTotalRecorded());
+		for(const FObjectTagHistoryRecord& CurrentRecord : Records)
+		{
+			UE_LOG(ObjectTagsHistoryLog, Display, TEXT("  %s"), *RecordToString(CurrentRecord));
+		}
+		return;
+	}
+
+	TArray<FString> Lines;
+	Lines.Reserve(Records.Num());
+	for(const FObjectTagHistoryRecord& CurrentRecord : Records)
+	{
+		Lines.Add(RecordToString(CurrentRecord));
+	}
+
+	const FString FilePath = FPaths::ProjectSavedDir() / TEXT("ObjectTags") / FPaths::GetCleanFilename(Args[0]);
+	if(FFileHelper::SaveStringArrayToFile(Lines, *FilePath))
+	{
+		UE_LOG(ObjectTagsHistoryLog, Display, TEXT("Wrote %d object tag history records to %s"), Records.Num(), *FilePath);
+	}
+	else
+	{
+		UE_LOG(ObjectTagsHistoryLog, Warning, TEXT("Failed to write object tag history to %s"), *FilePath);
+	}
+}
+
+#endif
@@ -0,0 +1,135 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+
+#include "ObjectTags_RelationshipIndex.h"
+
+#include "O_TagRelationship.h"
+#include "UObject/UObjectHash.h"
+
+FObjectTagRelationshipIndex& FObjectTagRelationshipIndex::Get()
+{
+	static FObjectTagRelationshipIndex Index;
+	return Index;
+}
+
+void FObjectTagRelationshipIndex::Build()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FObjectTagRelationshipIndex::Build)
+	TArray<UClass*> RelationshipClasses;
+	GetDerivedClasses(UO_TagRelationship::StaticClass(), RelationshipClasses, true);
+	
+	for(UClass* CurrentClass : RelationshipClasses)
+	{
+		//Skip blueprint compilation leftovers
+		if(CurrentClass->HasAnyClassFlags(CLASS_Abstract | CLASS_NewerVersionExists)
+			|| CurrentClass->GetName().StartsWith(TEXT("SKEL_")))
+		{
+			continue;
+		}
+
+		FindOrAddRelationshipId(CurrentClass);
+	}
+}
+
+void FObjectTagRelationshipIndex::Reset()
+{
+	Relationships.Reset();
+	ClassToRelationship.Reset();
+	BlockedBy.Reset();
+}
+
+int32 FObjectTagRelationshipIndex::FindOrAddRelationshipId(TSubclassOf<UO_TagRelationship> RelationshipClass)
+{
+	if(!RelationshipClass)
+	{
+		return INDEX_NONE;
+	}
+
+	const FObjectKey ClassKey(RelationshipClass.Get());
+	if(const int32* FoundId = ClassToRelationship.Find(ClassKey))
+	{
+		return *FoundId;
+	}
+
+	const UO_TagRelationship* RelationshipCDO = RelationshipClass.GetDefaultObject();
+	if(!RelationshipCDO)
+	{
+		return INDEX_NONE;
+	}
+
+	FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	auto FlattenTags = [&IndexTable](const FGameplayTagContainer& Container, TArray<uint16>& OutTagIndices)
+	{
+		OutTagIndices.Reserve(Container.Num());
+		for(const FGameplayTag& CurrentTag : Container)
+		{
+			const uint16 TagIndex = IndexTable.FindOrAddIndex(CurrentTag);
+			if(TagIndex != FObjectTagIndexTable::InvalidIndex)
+			{
+				OutTagIndices.AddUnique(TagIndex);
+			}
+		}
+		OutTagIndices.Sort();
+	};
+
+	const int32 NewId = Relationships.AddDefaulted();
+	FObjectTagRelationshipInfo& NewRelationship = Relationships[NewId];
+	NewRelationship.RelationshipClass = RelationshipClass.Get();
+	NewRelationship.TagIndex = IndexTable.FindOrAddIndex(RelationshipCDO->Tag);
+	NewRelationship.Value = RelationshipCDO->Value;
+	NewRelationship.bRemoveTagIfAnyBlockingTagIsApplied = RelationshipCDO->RemoveTagIfAnyBlockingTagIsApplied;
+	FlattenTags(RelationshipCDO->RequiredTags, NewRelationship.RequiredTags);
+	FlattenTags(RelationshipCDO->BlockingTags, NewRelationship.BlockingTags);
+	FlattenTags(RelationshipCDO->RemoveTags, NewRelationship.RemoveTags);
+
+	for(const uint16 TagIndex : NewRelationship.BlockingTags)
+	{
+		BlockedBy.FindOrAdd(TagIndex).Add(NewId);
+	}
+
+	ClassToRelationship.Add(ClassKey, NewId);
+	return NewId;
+}
+
+bool FObjectTagRelationshipIndex::HasAnyTagIndex(TConstArrayView<uint16> TagIndices, TConstArrayView<uint16> Other)
+{
+	int32 OtherSlot = 0;
+	for(const uint16 TagIndex : TagIndices)
+	{
+		while(OtherSlot < Other.Num() && Other[OtherSlot] < TagIndex)
+		{
+			OtherSlot++;
+		}
+
+		if(OtherSlot == Other.Num())
+		{
+			return false;
+		}
+
+		if(Other[OtherSlot] == TagIndex)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FObjectTagRelationshipIndex::HasAllTagIndices(TConstArrayView<uint16> TagIndices, TConstArrayView<uint16> Other)
+{
+	int32 OtherSlot = 0;
+	for(const uint16 TagIndex : TagIndices)
+	{
+		while(OtherSlot < Other.Num() && Other[OtherSlot] < TagIndex)
+		{
+			OtherSlot++;
+		}
+
+		if(OtherSlot == Other.Num() || Other[OtherSlot] != TagIndex)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
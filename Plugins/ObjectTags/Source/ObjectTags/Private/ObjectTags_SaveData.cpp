@@ -0,0 +1,415 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+
+#include "ObjectTags_SaveData.h"
+
+#include "ObjectTags_Subsystem.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(ObjectTagsSaveLog, Log, All)
+
+namespace ObjectTagsSaveData
+{
+	/**Floats are XOR'd against the previous value, so repeated values become 0
+	 * and pack into a single byte. The first value of every object is XOR'd
+	 * against 1, the default tag value.*/
+	static const uint32 DefaultValueBits = 0x3F800000;
+
+	static void WritePacked(FArchive& Ar, uint32 Value)
+	{
+		Ar.SerializeIntPacked(Value);
+	}
+
+	static uint32 ReadPacked(FArchive& Ar)
+	{
+		uint32 Value = 0;
+		Ar.SerializeIntPacked(Value);
+		return Value;
+	}
+
+	/**Every counted element takes at least a byte, so a count larger than
+	 * what is left of the archive can only come from corrupt data.
+	 * Flags the archive as errored instead of letting it be reserved or looped over.*/
+	static uint32 ReadCount(FArchive& Ar)
+	{
+		const uint32 Count = ReadPacked(Ar);
+		if(Ar.IsError() || Count > static_cast<uint64>(FMath::Max<int64>(Ar.TotalSize() - Ar.Tell(), 0)))
+		{
+			Ar.SetError();
+			return 0;
+		}
+		return Count;
+	}
+
+	/**One object read from the save, its tags, timers and relationships
+	 * are ranges in the flat staging arrays of LoadTagState.*/
+	struct FLoadedObject
+	{
+		UObject* Object = nullptr;
+		int32 FirstTag = 0;
+		int32 NumTags = 0;
+		int32 FirstTimer = 0;
+		int32 NumTimers = 0;
+		int32 FirstRelationship = 0;
+		int32 NumRelationships = 0;
+	};
+
+	/**Only objects that have the same path next session can be loaded again.
+	 * Runtime spawned actors, and every component or object inside them, can't.*/
+	static bool HasStablePath(const UObject* Object)
+	{
+		for(const UObject* CurrentObject = Object; CurrentObject && !CurrentObject->IsA<UPackage>(); CurrentObject = CurrentObject->GetOuter())
+		{
+			if(!CurrentObject->IsAsset() && !CurrentObject->IsNameStableForNetworking())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int32 UObjectTags_Subsystem::SaveTagState(TArray<uint8>& OutData) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(SaveTagState)
+	using namespace ObjectTagsSaveData;
+	
+	OutData.Reset();
+	FMemoryWriter Writer(OutData, true);
+
+	uint32 SaveMagic = Magic;
+	uint16 Version = static_cast<uint16>(EObjectTagsSaveVersion::Latest);
+	Writer << SaveMagic;
+	Writer << Version;
+
+	//Only objects that have something worth saving and that can be found again.
+	TArray<const FObjectTagEntry*> SavedObjects;
+	SavedObjects.Reserve(ObjectTags.Num());
+	TBitArray<> UsedTags(false, FObjectTagIndexTable::Get().Num());
+	TArray<UClass*> RelationshipClasses;
+	for(const TPair<TObjectPtr<UObject>, FObjectTagEntry>& CurrentObject : ObjectTags)
+	{
+		const FObjectTagEntry& ObjectTag = CurrentObject.Value;
+		if(!IsValid(ObjectTag.Object) || (!ObjectTag.HasAnyTags() && ObjectTag.TagRelationships.IsEmpty())
+			|| !HasStablePath(ObjectTag.Object))
+		{
+			continue;
+		}
+
+		SavedObjects.Add(&ObjectTag);
+		for(const uint16 TagIndex : ObjectTag.TagIndices)
+		{
+			UsedTags[TagIndex] = true;
+		}
+		for(const TSubclassOf<UO_TagRelationship>& CurrentRelationship : ObjectTag.TagRelationships)
+		{
+			if(CurrentRelationship)
+			{
+				RelationshipClasses.AddUnique(CurrentRelationship.Get());
+			}
+		}
+	}
+
+	//Tag table, walking the bits in order keeps the table sorted by tag index.
+	const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	TArray<uint32> TagToTableIndex;
+	TagToTableIndex.SetNumZeroed(UsedTags.Num());
+	uint32 TableSize = 0;
+	for(TConstSetBitIterator<> It(UsedTags); It; ++It)
+	{
+		TagToTableIndex[It.GetIndex()] = TableSize++;
+	}
+	
+	WritePacked(Writer, TableSize);
+	for(TConstSetBitIterator<> It(UsedTags); It; ++It)
+	{
+		FString TagName = IndexTable.GetTag(It.GetIndex()).ToString();
+		Writer << TagName;
+	}
+
+	WritePacked(Writer, RelationshipClasses.Num());
+	for(UClass* CurrentClass : RelationshipClasses)
+	{
+		FString ClassPath = FSoftClassPath(CurrentClass).ToString();
+		Writer << ClassPath;
+	}
+
+	WritePacked(Writer, SavedObjects.Num());
+	for(const FObjectTagEntry* ObjectTag : SavedObjects)
+	{
+		FString ObjectPath = FSoftObjectPath(ObjectTag->Object.Get()).ToString();
+		Writer << ObjectPath;
+
+		//Tags are sorted by tag index, so the table indices are ascending too.
+		WritePacked(Writer, ObjectTag->NumTags());
+		uint32 PreviousTableIndex = 0;
+		for(const uint16 TagIndex : ObjectTag->TagIndices)
+		{
+			WritePacked(Writer, TagToTableIndex[TagIndex] - PreviousTableIndex);
+			PreviousTableIndex = TagToTableIndex[TagIndex];
+		}
+
+		uint32 PreviousBits = DefaultValueBits;
+		for(const float Value : ObjectTag->TagValues)
+		{
+			const uint32 Bits = FMath::AsUInt(Value);
+			WritePacked(Writer, Bits ^ PreviousBits);
+			PreviousBits = Bits;
+		}
+
+		//Temporary tags, written as their position in the objects tags.
+		TArray<TPair<uint32, float>, TInlineAllocator<8>> Timers;
+		for(int32 CurrentTag = 0; CurrentTag < ObjectTag->NumTags(); CurrentTag++)
+		{
+			const double RemainingTime = TagExpiryScheduler.GetRemainingTime(ObjectTag->Object, ObjectTag->TagIndices[CurrentTag]);
+			if(RemainingTime >= 0)
+			{
+				Timers.Emplace(CurrentTag, static_cast<float>(RemainingTime));
+			}
+		}
+		
+		WritePacked(Writer, Timers.Num());
+		for(TPair<uint32, float>& CurrentTimer : Timers)
+		{
+			WritePacked(Writer, CurrentTimer.Key);
+			Writer << CurrentTimer.Value;
+		}
+
+		WritePacked(Writer, ObjectTag->TagRelationships.Num());
+		for(const TSubclassOf<UO_TagRelationship>& CurrentRelationship : ObjectTag->TagRelationships)
+		{
+			WritePacked(Writer, RelationshipClasses.IndexOfByKey(CurrentRelationship.Get()));
+		}
+	}
+
+	return SavedObjects.Num();
+}
+
+bool UObjectTags_Subsystem::LoadTagState(const TArray<uint8>& Data)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(LoadTagState)
+	using namespace ObjectTagsSaveData;
+	
+	FMemoryReader Reader(Data, true);
+
+	uint32 SaveMagic = 0;
+	uint16 Version = 0;
+	Reader << SaveMagic;
+	Reader << Version;
+	if(Reader.IsError() || SaveMagic != Magic
+		|| Version < static_cast<uint16>(EObjectTagsSaveVersion::Initial) || Version > static_cast<uint16>(EObjectTagsSaveVersion::Latest))
+	{
+		UE_LOG(ObjectTagsSaveLog, Warning, TEXT("Object tags save data is corrupt or from a newer version (%u)"), Version);
+		return false;
+	}
+
+	FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	
+	const uint32 TableSize = ReadCount(Reader);
+	TArray<uint16> TableToTagIndex;
+	TableToTagIndex.Reserve(TableSize);
+	for(uint32 CurrentTag = 0; CurrentTag < TableSize && !Reader.IsError(); CurrentTag++)
+	{
+		FString TagName;
+		Reader << TagName;
+		//Tags that were removed from the project since the save are dropped.
+		TableToTagIndex.Add(IndexTable.FindOrAddIndex(FGameplayTag::RequestGameplayTag(FName(TagName), false)));
+	}
+
+	const uint32 RelationshipCount = ReadCount(Reader);
+	TArray<TSubclassOf<UO_TagRelationship>> Relationships;
+	for(uint32 CurrentRelationship = 0; CurrentRelationship < RelationshipCount && !Reader.IsError(); CurrentRelationship++)
+	{
+		FString ClassPath;
+		Reader << ClassPath;
+		Relationships.Add(FSoftClassPath(ClassPath).TryLoadClass<UO_TagRelationship>());
+	}
+
+	//Every object is read into flat staging arrays first, so corrupt data
+	//is caught before anything in the current state is touched.
+	const uint32 ObjectCount = ReadCount(Reader);
+	TArray<FLoadedObject> LoadedObjects;
+	TArray<TPair<uint16, float>> LoadedTags;
+	TArray<TPair<uint16, float>> LoadedTimers;
+	TArray<TSubclassOf<UO_TagRelationship>> LoadedRelationships;
+	LoadedObjects.Reserve(ObjectCount);
+	
+	int32 MissingObjects = 0;
+	for(uint32 CurrentObject = 0; CurrentObject < ObjectCount && !Reader.IsError(); CurrentObject++)
+	{
+		FString ObjectPath;
+		Reader << ObjectPath;
+
+		FLoadedObject LoadedObject;
+		LoadedObject.FirstTag = LoadedTags.Num();
+		LoadedObject.FirstTimer = LoadedTimers.Num();
+		LoadedObject.FirstRelationship = LoadedRelationships.Num();
+
+		const uint32 TagCount = ReadCount(Reader);
+		uint32 TableIndex = 0;
+		for(uint32 CurrentTag = 0; CurrentTag < TagCount && !Reader.IsError(); CurrentTag++)
+		{
+			TableIndex += ReadPacked(Reader);
+			LoadedTags.Emplace(TableToTagIndex.IsValidIndex(TableIndex) ? TableToTagIndex[TableIndex] : FObjectTagIndexTable::InvalidIndex, 0.f);
+		}
+
+		uint32 PreviousBits = DefaultValueBits;
+		for(int32 CurrentTag = LoadedObject.FirstTag; CurrentTag < LoadedTags.Num() && !Reader.IsError(); CurrentTag++)
+		{
+			PreviousBits ^= ReadPacked(Reader);
+			LoadedTags[CurrentTag].Value = FMath::AsFloat(PreviousBits);
+		}
+
+		//Remaining durations, keyed by tag index since the tags get sorted below.
+		const uint32 TimerCount = ReadCount(Reader);
+		for(uint32 CurrentTimer = 0; CurrentTimer < TimerCount && !Reader.IsError(); CurrentTimer++)
+		{
+			const uint32 TagPosition = ReadPacked(Reader);
+			float RemainingTime = 0;
+			Reader << RemainingTime;
+			if(TagPosition < TagCount && LoadedTags.IsValidIndex(LoadedObject.FirstTag + TagPosition))
+			{
+				LoadedTimers.Emplace(LoadedTags[LoadedObject.FirstTag + TagPosition].Key, RemainingTime);
+			}
+		}
+
+		const uint32 ObjectRelationshipCount = ReadCount(Reader);
+		for(uint32 CurrentRelationship = 0; CurrentRelationship < ObjectRelationshipCount && !Reader.IsError(); CurrentRelationship++)
+		{
+			const uint32 RelationshipIndex = ReadPacked(Reader);
+			if(Relationships.IsValidIndex(RelationshipIndex) && Relationships[RelationshipIndex])
+			{
+				LoadedRelationships.Add(Relationships[RelationshipIndex]);
+			}
+		}
+
+		LoadedObject.Object = FSoftObjectPath(ObjectPath).ResolveObject();
+		if(!LoadedObject.Object)
+		{
+			//Runtime spawned objects can't be found by path again.
+			MissingObjects++;
+			LoadedTags.SetNum(LoadedObject.FirstTag, EAllowShrinking::No);
+			LoadedTimers.SetNum(LoadedObject.FirstTimer, EAllowShrinking::No);
+			LoadedRelationships.SetNum(LoadedObject.FirstRelationship, EAllowShrinking::No);
+			continue;
+		}
+
+		LoadedObject.NumTags = LoadedTags.Num() - LoadedObject.FirstTag;
+		LoadedObject.NumTimers = LoadedTimers.Num() - LoadedObject.FirstTimer;
+		LoadedObject.NumRelationships = LoadedRelationships.Num() - LoadedObject.FirstRelationship;
+		LoadedObjects.Add(LoadedObject);
+	}
+
+	if(Reader.IsError())
+	{
+		UE_LOG(ObjectTagsSaveLog, Warning, TEXT("Object tags save data is corrupt, nothing was loaded"));
+		return false;
+	}
+
+	//Wipe the current state, but keep the entries that are being listened to.
+	for(auto It = ObjectTags.CreateIterator(); It; ++It)
+	{
+		FObjectTagEntry& ObjectTag = It.Value();
+
+		//The ability system would otherwise keep the loose tags of the old state.
+		SyncLooseTags(ObjectTag, {}, ObjectTag.GetTagsAsContainer().GetGameplayTagArray());
+
+		ObjectTag.TagIndices.Reset();
+		ObjectTag.TagValues.Reset();
+		ObjectTag.TagRelationships.Reset();
+		ObjectTag.bCachedTagsContainerDirty = true;
+		ObjectTag.MarkModified();
+		if(!ObjectTag.HasAnyListeners())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	TagReverseIndex.Reset();
+	TagExpiryScheduler.Reset();
+
+	ObjectTags.Reserve(ObjectTags.Num() + LoadedObjects.Num());
+	for(const FLoadedObject& LoadedObject : LoadedObjects)
+	{
+		//Tag indices aren't stable between sessions, so the order has to be rebuilt.
+		TArrayView<TPair<uint16, float>> ObjectLoadedTags(LoadedTags.GetData() + LoadedObject.FirstTag, LoadedObject.NumTags);
+		ObjectLoadedTags.Sort([](const TPair<uint16, float>& A, const TPair<uint16, float>& B)
+		{
+			return A.Key < B.Key;
+		});
+
+		FObjectTagEntry& ObjectTag = FindOrAddObjectTag(LoadedObject.Object);
+		if(ObjectTag.HasAnyTags() || !ObjectTag.TagRelationships.IsEmpty())
+		{
+			//Everything was wiped above, so this object was already in the save.
+			continue;
+		}
+		ObjectTag.TagIndices.Reserve(LoadedObject.NumTags);
+		ObjectTag.TagValues.Reserve(LoadedObject.NumTags);
+		FGameplayTagContainer LoadedContainer;
+		for(const TPair<uint16, float>& CurrentTag : ObjectLoadedTags)
+		{
+			//Dropped tags sort to the end. Duplicates only show up in corrupt data.
+			if(CurrentTag.Key == FObjectTagIndexTable::InvalidIndex)
+			{
+				break;
+			}
+			if(!ObjectTag.TagIndices.IsEmpty() && ObjectTag.TagIndices.Last() == CurrentTag.Key)
+			{
+				continue;
+			}
+			ObjectTag.TagIndices.Add(CurrentTag.Key);
+			ObjectTag.TagValues.Add(CurrentTag.Value);
+			LoadedContainer.AddTagFast(IndexTable.GetTag(CurrentTag.Key));
+		}
+		ObjectTag.TagRelationships.Append(LoadedRelationships.GetData() + LoadedObject.FirstRelationship, LoadedObject.NumRelationships);
+		ObjectTag.bCachedTagsContainerDirty = true;
+		ObjectTag.MarkModified();
+
+		for(const FGameplayTag& CurrentTag : LoadedContainer)
+		{
+			AddToReverseIndex(LoadedObject.Object, CurrentTag);
+		}
+
+		for(int32 CurrentTimer = LoadedObject.FirstTimer; CurrentTimer < LoadedObject.FirstTimer + LoadedObject.NumTimers; CurrentTimer++)
+		{
+			//The modifier is a runtime object, it can't survive a save.
+			if(LoadedTimers[CurrentTimer].Key != FObjectTagIndexTable::InvalidIndex)
+			{
+				TagExpiryScheduler.Schedule(LoadedObject.Object, LoadedTimers[CurrentTimer].Key, nullptr, LoadedTimers[CurrentTimer].Value);
+			}
+		}
+
+		SyncLooseTags(ObjectTag, LoadedContainer.GetGameplayTagArray(), {});
+	}
+
+	if(MissingObjects > 0)
+	{
+		UE_LOG(ObjectTagsSaveLog, Verbose, TEXT("%d saved objects could not be found and were skipped"), MissingObjects);
+	}
+
+	return true;
+}
+
+bool UObjectTags_Subsystem::SaveObjectTagsToBytes(TArray<uint8>& OutData)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem)
+	{
+		return false;
+	}
+
+	ObjectTags_Subsystem->SaveTagState(OutData);
+	return true;
+}
+
+bool UObjectTags_Subsystem::LoadObjectTagsFromBytes(const TArray<uint8>& Data)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem)
+	{
+		return false;
+	}
+
+	return ObjectTags_Subsystem->LoadTagState(Data);
+}
@@ -0,0 +1,232 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+
+#include "ObjectTags_Snapshot.h"
+
+#include "ObjectTags_Subsystem.h"
+
+DEFINE_LOG_CATEGORY_STATIC(ObjectTagsSnapshotLog, Log, All)
+
+namespace ObjectTagsSnapshotRegistry
+{
+	/**One per running game instance, PIE with several clients runs more than one.*/
+	static constexpr int32 MaxSnapshots = 16;
+
+	struct FSlot
+	{
+		std::atomic<const FObjectTagsSnapshot*> Snapshot = nullptr;
+
+		/**Queries that are reading, or about to read, the snapshot in this slot.*/
+		std::atomic<int32> Readers = 0;
+	};
+
+	static FSlot Slots[MaxSnapshots];
+
+	/**Slots past this have never been used, so queries don't look at them.*/
+	static std::atomic<int32> NumUsedSlots = 0;
+}
+
+const float* FObjectTagsSnapshotData::FindValue(const FObjectKey& Object, const FGameplayTag& Tag) const
+{
+	const FObjectRange* Range = Objects.Find(Object);
+	if(!Range)
+	{
+		return nullptr;
+	}
+
+	//Objects rarely have more than a handful of tags, a linear scan is cheaper than anything fancier.
+	for(int32 CurrentTag = Range->Start; CurrentTag < Range->Start + Range->Num; CurrentTag++)
+	{
+		if(Tags[CurrentTag] == Tag)
+		{
+			return &Values[CurrentTag];
+		}
+	}
+
+	return nullptr;
+}
+
+void FObjectTagsSnapshot::Reset()
+{
+	check(IsInGameThread());
+
+	CurrentBuffer.store(INDEX_NONE);
+	for(FObjectTagsSnapshotData& Data : Buffers)
+	{
+		Data.Objects.Empty();
+		Data.Tags.Empty();
+		Data.Values.Empty();
+	}
+	PublishedRevision = 0;
+}
+
+bool FObjectTagsSnapshot::Publish(const TMap<TObjectPtr<UObject>, FObjectTagEntry>& ObjectTags, uint32 Revision)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FObjectTagsSnapshot::Publish)
+	check(IsInGameThread());
+
+	//Find a buffer nobody can be reading. A reader that pins a buffer after
+	//this check will see it's no longer current and try again.
+	const int32 Current = CurrentBuffer.load();
+	int32 FreeBuffer = INDEX_NONE;
+	for(int32 CurrentIndex = 0; CurrentIndex < BufferCount; CurrentIndex++)
+	{
+		if(CurrentIndex != Current && ReaderCounts[CurrentIndex].load() == 0)
+		{
+			FreeBuffer = CurrentIndex;
+			break;
+		}
+	}
+
+	if(FreeBuffer == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FObjectTagsSnapshotData& Data = Buffers[FreeBuffer];
+	Data.Objects.Reset();
+	Data.Tags.Reset();
+	Data.Values.Reset();
+	Data.Objects.Reserve(ObjectTags.Num());
+
+	const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	for(const TPair<TObjectPtr<UObject>, FObjectTagEntry>& CurrentObject : ObjectTags)
+	{
+		if(!CurrentObject.Value.Object || !CurrentObject.Value.HasAnyTags())
+		{
+			continue;
+		}
+
+		FObjectTagsSnapshotData::FObjectRange& Range = Data.Objects.Add(FObjectKey(CurrentObject.Value.Object));
+		Range.Start = Data.Tags.Num();
+		Range.Num = CurrentObject.Value.NumTags();
+		for(const uint16 TagIndex : CurrentObject.Value.TagIndices)
+		{
+			Data.Tags.Add(IndexTable.GetTag(TagIndex));
+		}
+		Data.Values.Append(CurrentObject.Value.TagValues);
+	}
+
+	CurrentBuffer.store(FreeBuffer);
+	PublishedRevision = Revision;
+	return true;
+}
+
+void FObjectTagsSnapshot::Register()
+{
+	using namespace ObjectTagsSnapshotRegistry;
+	check(IsInGameThread());
+
+	for(int32 CurrentSlot = 0; CurrentSlot < MaxSnapshots; CurrentSlot++)
+	{
+		if(!Slots[CurrentSlot].Snapshot.load())
+		{
+			Slots[CurrentSlot].Snapshot.store(this);
+			NumUsedSlots.store(FMath::Max(NumUsedSlots.load(), CurrentSlot + 1));
+			return;
+		}
+	}
+
+	UE_LOG(ObjectTagsSnapshotLog, Warning, TEXT("More than %d game instances are running, the _AnyThread object tag queries won't see the tags of this one"), MaxSnapshots);
+}
+
+void FObjectTagsSnapshot::Unregister()
+{
+	using namespace ObjectTagsSnapshotRegistry;
+	check(IsInGameThread());
+
+	for(FSlot& Slot : Slots)
+	{
+		if(Slot.Snapshot.load() == this)
+		{
+			//A query that pinned the slot before this store is counted in Readers,
+			//one that pins it after will see it's empty.
+			Slot.Snapshot.store(nullptr);
+			while(Slot.Readers.load() != 0)
+			{
+				FPlatformProcess::Yield();
+			}
+			return;
+		}
+	}
+}
+
+bool FObjectTagsSnapshot::FindTagValue_AnyThread(const UObject* Object, const FGameplayTag& Tag, float& OutValue)
+{
+	using namespace ObjectTagsSnapshotRegistry;
+
+	const int32 NumSlots = NumUsedSlots.load();
+	for(int32 CurrentSlot = 0; CurrentSlot < NumSlots; CurrentSlot++)
+	{
+		FSlot& Slot = Slots[CurrentSlot];
+		if(!Slot.Snapshot.load())
+		{
+			continue;
+		}
+
+		//Same as PinCurrentBuffer, only trust the snapshot if it's still there after pinning the slot.
+		Slot.Readers.fetch_add(1);
+		const FObjectTagsSnapshot* Snapshot = Slot.Snapshot.load();
+		const bool bFound = Snapshot && Snapshot->GetTagValue(Object, Tag, OutValue);
+		Slot.Readers.fetch_sub(1);
+		
+		if(bFound)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int32 FObjectTagsSnapshot::PinCurrentBuffer() const
+{
+	while(true)
+	{
+		const int32 Current = CurrentBuffer.load();
+		if(Current == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+
+		ReaderCounts[Current].fetch_add(1);
+
+		//If the buffer is still current after pinning it, the game thread
+		//can't start writing into it until we unpin.
+		if(CurrentBuffer.load() == Current)
+		{
+			return Current;
+		}
+
+		ReaderCounts[Current].fetch_sub(1);
+	}
+}
+
+bool FObjectTagsSnapshot::DoesObjectHaveTag(const UObject* Object, const FGameplayTag& Tag) const
+{
+	float Value = 0;
+	return GetTagValue(Object, Tag, Value);
+}
+
+bool FObjectTagsSnapshot::GetTagValue(const UObject* Object, const FGameplayTag& Tag, float& OutValue) const
+{
+	if(!Object || !Tag.IsValid())
+	{
+		return false;
+	}
+
+	const int32 BufferIndex = PinCurrentBuffer();
+	if(BufferIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const float* Value = Buffers[BufferIndex].FindValue(FObjectKey(Object), Tag);
+	if(Value)
+	{
+		OutValue = *Value;
+	}
+	
+	UnpinBuffer(BufferIndex);
+	return Value != nullptr;
+}
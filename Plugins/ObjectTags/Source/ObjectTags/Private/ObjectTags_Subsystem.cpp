@@ -7,18 +7,44 @@
 #include "AbilitySystemComponent.h"
 #include "GameplayTagsManager.h"
 #include "I_ObjectTagsCommunication.h"
+#include "ObjectTags_History.h"
+#include "ObjectTags_RelationshipIndex.h"
+#include "ObjectTags_Snapshot.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetSystemLibrary.h"
 
 DEFINE_LOG_CATEGORY_STATIC(ObjectTagsLog, Log, All)
 
+DECLARE_STATS_GROUP(TEXT("ObjectTags"), STATGROUP_ObjectTags, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Entries Reclaimed"), STAT_ObjectTagsEntriesReclaimed, STATGROUP_ObjectTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Entries Swept"), STAT_ObjectTagsEntriesSwept, STATGROUP_ObjectTags);
+
+static TAutoConsoleVariable<bool> CVarObjectTagsDeferAbilitySystemSync(
+	TEXT("ObjectTags.DeferAbilitySystemSync"),
+	false,
+	TEXT("If true, loose gameplay tag changes are gathered and applied to each ability system component once per frame, instead of as soon as the tag changes."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarObjectTagsCleanupBudget(
+	TEXT("ObjectTags.CleanupBudget"),
+	64,
+	TEXT("How many object tag entries are checked for stale objects each frame."),
+	ECVF_Default);
+
 void UObjectTags_Subsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
 
 	ObjectTags.Empty();
 
-	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UObjectTags_Subsystem::CleanupObjectTagArray);
+	FObjectTagIndexTable::Get().Initialize();
+
+	Snapshot.Register();
+	FObjectTagRelationshipIndex::Get().Build();
+
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectsReplaced.AddUObject(this, &UObjectTags_Subsystem::OnObjectsReplaced);
+#endif
 	
 	IConsoleManager::Get().RegisterConsoleCommand(
 		TEXT("AddTag"),
@@ -43,6 +69,65 @@ void UObjectTags_Subsystem::Initialize(FSubsystemCollectionBase& Collection)
 		TEXT("Remove a tag from the player pawn"),
 			FConsoleCommandWithArgsDelegate::CreateStatic(&RemoveTagFromPlayerConsoleCommand),
 			ECVF_Default);
+
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("ObjectTags.MemoryReport"),
+		TEXT("Print how much memory the tag storage uses per object."),
+			FConsoleCommandDelegate::CreateStatic(&MemoryReportConsoleCommand),
+			ECVF_Default);
+
+#if OBJECTTAGS_WITH_HISTORY
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("ObjectTags.DumpHistory"),
+		TEXT("ObjectTags.DumpHistory [FileName]. Log every tag change in the history buffer, or write it to Saved/ObjectTags/FileName."),
+			FConsoleCommandWithArgsDelegate::CreateStatic(&FObjectTagHistoryBuffer::DumpHistoryConsoleCommand),
+			ECVF_Default);
+#endif
+}
+
+void UObjectTags_Subsystem::Deinitialize()
+{
+	//Waits for any _AnyThread query that is still reading the snapshot.
+	Snapshot.Unregister();
+	Snapshot.Reset();
+	StateRevision = 0;
+
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectsReplaced.RemoveAll(this);
+#endif
+
+	Super::Deinitialize();
+}
+
+void UObjectTags_Subsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UObjectTags_Subsystem::Tick)
+	ReclaimDestroyedObjects();
+	ExpireTags(DeltaTime);
+	SweepStaleObjects(CVarObjectTagsCleanupBudget.GetValueOnGameThread());
+
+	FlushLooseTags();
+
+	//Publish once per frame, after everything this frame has been applied.
+	if(Snapshot.GetPublishedRevision() != StateRevision)
+	{
+		Snapshot.Publish(ObjectTags, StateRevision);
+	}
+}
+
+TStatId UObjectTags_Subsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UObjectTags_Subsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UObjectTags_Subsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+UWorld* UObjectTags_Subsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
 }
 
 UObjectTags_Subsystem* UObjectTags_Subsystem::Get()
@@ -73,14 +158,68 @@ FObjectTag UObjectTags_Subsystem::GetObjectTags(UObject* Object)
 		return FObjectTag();
 	}
 
-	if(FObjectTag* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object))
+	if(FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object))
 	{
-		return *FoundObject;
+		return FoundObject->MakeBlueprintCopy();
 	}
 
 	return FObjectTag();
 }
 
+const FObjectTagEntry* UObjectTags_Subsystem::FindObjectTags(UObject* Object)
+{
+	if(!Object)
+	{
+		return nullptr;
+	}
+	
+	const UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem)
+	{
+		return nullptr;
+	}
+
+	return ObjectTags_Subsystem->ObjectTags.Find(Object);
+}
+
+const TMap<TObjectPtr<UObject>, FObjectTagEntry>* UObjectTags_Subsystem::GetAllObjectTags()
+{
+	const UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	return ObjectTags_Subsystem ? &ObjectTags_Subsystem->ObjectTags : nullptr;
+}
+
+TMap<FGameplayTag, float> UObjectTags_Subsystem::GetObjectTagsAndValues(UObject* Object)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!Object || !ObjectTags_Subsystem)
+	{
+		return TMap<FGameplayTag, float>();
+	}
+
+	if(const FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object))
+	{
+		return FoundObject->GetTagsAndValues();
+	}
+
+	return TMap<FGameplayTag, float>();
+}
+
+FGameplayTagContainer UObjectTags_Subsystem::GetObjectTagsAsContainer(UObject* Object)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!Object || !ObjectTags_Subsystem)
+	{
+		return FGameplayTagContainer();
+	}
+
+	if(const FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object))
+	{
+		return FoundObject->GetTagsAsContainer();
+	}
+
+	return FGameplayTagContainer();
+}
+
 bool UObjectTags_Subsystem::AddTagToObject(FGameplayTag TagToAdd, UObject* Object, UObject* Modifier, float Value, float Duration)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(AddTagToObject)
@@ -96,26 +235,15 @@ bool UObjectTags_Subsystem::AddTagToObject(FGameplayTag TagToAdd, UObject* Objec
 	}
 
 	bool bTagAdded = false;
-	FObjectTag* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
+	FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
 	if(FoundObject)
 	{
 		//Append the two tag containers and call the TagsModified delegate on the way. - V
-		if(!FoundObject->TagsAndValues.Find(TagToAdd))
+		if(FoundObject->SetTag(TagToAdd, Value))
 		{
-			FoundObject->TagsAndValues.Add(TagToAdd, Value);
+			ObjectTags_Subsystem->AddToReverseIndex(Object, TagToAdd);
+			ObjectTags_Subsystem->SyncLooseTags(*FoundObject, MakeArrayView(&TagToAdd, 1), {});
 			AActor* TargetActor = Cast<AActor>(FoundObject->Object.Get());
-			if(TargetActor)
-			{
-				FGameplayTagContainer ASCTags;
-				if(UAbilitySystemComponent* AbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(TargetActor))
-				{
-					AbilitySystemComponent->GetOwnedGameplayTags(ASCTags);
-					if(!ASCTags.HasTagExact(TagToAdd))
-					{
-						UAbilitySystemBlueprintLibrary::AddLooseGameplayTags(TargetActor, FGameplayTagContainer({TagToAdd}), true);
-					}
-				}
-			}
 
 			FoundObject->BroadcastTagChange(TagToAdd, Added, Modifier, Value);
 
@@ -136,15 +264,15 @@ bool UObjectTags_Subsystem::AddTagToObject(FGameplayTag TagToAdd, UObject* Objec
 			if(FoundObject->TagRelationships.IsValidIndex(0))
 			{
 				//Find out if any current relationships would be removed from the application of this tag.
-				for(int32 CurrentRelationship = 0; CurrentRelationship < FoundObject->TagRelationships.Num(); CurrentRelationship++)
+				FGameplayTagContainer RelationshipTagsToRemove;
+				const uint16 TagIndex = FObjectTagIndexTable::Get().FindIndex(TagToAdd);
+				ObjectTags_Subsystem->RemoveBlockedRelationships(*FoundObject, MakeArrayView(&TagIndex, 1), RelationshipTagsToRemove);
+
+				//Every blocked relationship is removed in a single pass.
+				//FoundObject isn't used after this, removing tags can remove the entry.
+				if(!RelationshipTagsToRemove.IsEmpty())
 				{
-					UO_TagRelationship* CurrentTagCDO = FoundObject->TagRelationships[CurrentRelationship].GetDefaultObject();
-					if(CurrentTagCDO->BlockingTags.HasTagExact(TagToAdd))
-					{
-						ObjectTags_Subsystem->RemoveTagsFromObject(FGameplayTagContainer({CurrentTagCDO->Tag}), Object, Modifier);
-						FoundObject->TagRelationships.RemoveAt(CurrentRelationship);
-						CurrentRelationship--;
-					}
+					ObjectTags_Subsystem->RemoveTagsFromObject(RelationshipTagsToRemove, Object, Modifier);
 				}
 			}
 			
@@ -154,8 +282,7 @@ bool UObjectTags_Subsystem::AddTagToObject(FGameplayTag TagToAdd, UObject* Objec
 		}
 		else
 		{
-			//Object was found and already has the tag. Update the value.
-			FoundObject->TagsAndValues.Add(TagToAdd, Value);
+			//Object was found and already has the tag, SetTag has updated the value.
 			bTagAdded = true;
 			
 			FoundObject->BroadcastTagChange(TagToAdd, Added, Modifier, Value);
@@ -178,78 +305,31 @@ bool UObjectTags_Subsystem::AddTagToObject(FGameplayTag TagToAdd, UObject* Objec
 	else
 	{
 		//Object doesn't have the tag, add it
-		FObjectTag NewObjectTag;
-		NewObjectTag.Object = Object;
+		FObjectTagEntry NewObjectTag;
+		NewObjectTag.SetObject(Object, ObjectTags_Subsystem->StateRevision);
 		
-		NewObjectTag.TagsAndValues.Add(TagToAdd, Value);
+		NewObjectTag.SetTag(TagToAdd, Value);
 		ObjectTags_Subsystem->ObjectTags.Add(Object, NewObjectTag);
-
-		if(AActor* TargetActor = Cast<AActor>(Object))
-		{
-			FGameplayTagContainer ASCTags;
-			if(UAbilitySystemComponent* AbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(TargetActor))
-			{
-				AbilitySystemComponent->GetOwnedGameplayTags(ASCTags);
-				if(!ASCTags.HasTagExact(TagToAdd))
-				{
-					UAbilitySystemBlueprintLibrary::AddLooseGameplayTags(TargetActor, FGameplayTagContainer({TagToAdd}), true);
-				}
-			}
-		}
+		ObjectTags_Subsystem->TrackObjectDestruction(Object);
+		ObjectTags_Subsystem->AddToReverseIndex(Object, TagToAdd);
+		ObjectTags_Subsystem->SyncLooseTags(ObjectTags_Subsystem->ObjectTags.FindChecked(Object), MakeArrayView(&TagToAdd, 1), {});
 
 		NewObjectTag.BroadcastTagChange(TagToAdd, Added, Modifier, Value);
-
-#if WITH_EDITOR
-		if(ObjectTags_Subsystem->CollectDebuggingData)
-		{
-			FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
-		}
-#endif
 		
 		bTagAdded = true;
 	}
 
-#if WITH_EDITOR
-
+#if OBJECTTAGS_WITH_HISTORY
 	if(bTagAdded && ObjectTags_Subsystem->CollectDebuggingData)
 	{
-		if(!FoundObject)
-		{
-			FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
-			if(FoundObject)
-			{
-				FoundObject->TagHistory.Add(FObjectTagHistory(UKismetSystemLibrary::GetDisplayName(Modifier), TagToAdd, true));
-			}
-		}
-		else
-		{
-			FoundObject->TagHistory.Add(FObjectTagHistory(UKismetSystemLibrary::GetDisplayName(Modifier), TagToAdd, true));
-		}
+		FObjectTagHistoryBuffer::Get().Record(Object, FObjectTagIndexTable::Get().FindIndex(TagToAdd), Added, Modifier);
 	}
-	
 #endif
 
 	//Set up the timer to have the tag automatically remove itself
 	if(bTagAdded && Duration > 0)
 	{
-		//Find and clear any current timers for this tag, so we can refresh the duration.
-		if(FTimerHandle* OldHandle =FoundObject->TagTimers.Find(TagToAdd))
-		{
-			ObjectTags_Subsystem->GetWorld()->GetTimerManager().ClearTimer(*OldHandle);
-		}
-
-		//Start the timer and pass the needed variables to remove the tag in the future.
-		FTimerHandle NewHandle;
-		ObjectTags_Subsystem->GetWorld()->GetTimerManager().SetTimer(NewHandle, FTimerDelegate::CreateLambda([TagToAdd, Object, Modifier]
-		{
-			if(Object)
-			{
-				UObjectTags_Subsystem::RemoveTagsFromObject(FGameplayTagContainer({TagToAdd}), Object, IsValid(Modifier) ? Modifier : nullptr);
-			}
-		}), Duration, false);
-
-		//Add the handle so it's possible to refresh the duration if we try to add the tag again.
-		FoundObject->TagTimers.Add(TagToAdd, NewHandle);
+		ObjectTags_Subsystem->SetTagTimer(Object, TagToAdd, Modifier, Duration);
 	}
 
 	return bTagAdded;
@@ -265,60 +345,68 @@ bool UObjectTags_Subsystem::AddTagToObjectWithRelationship(TSubclassOf<UO_TagRel
 		return false;
 	}
 	
-	UO_TagRelationship* TagCDO = TagRelationship.GetDefaultObject();
-	if(!TagCDO)
+	FObjectTagRelationshipIndex& RelationshipIndex = FObjectTagRelationshipIndex::Get();
+	const int32 RelationshipId = RelationshipIndex.FindOrAddRelationshipId(TagRelationship);
+	if(RelationshipId == INDEX_NONE || !Object)
 	{
 		return false;	
 	}
 
-	FObjectTag* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
+	//Copied, indexing other relationships can move it.
+	const FObjectTagRelationshipInfo Relationship = RelationshipIndex.GetRelationship(RelationshipId);
+	const FGameplayTag RelationshipTag = FObjectTagIndexTable::Get().GetTag(Relationship.TagIndex);
+
+	FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
 	if(FoundObject && FoundObject->Object)
 	{
-		//Logic is a lot simpler by just using the TagContainer helper functions
-		FGameplayTagContainer TagContainer = FoundObject->GetTagsAsContainer();
-			
 		//Check if object already has the tag.
-		if(TagContainer.HasTagExact(TagCDO->Tag))
+		if(FoundObject->FindTagSlot(Relationship.TagIndex) != INDEX_NONE)
 		{
 			return false;
 		}
 
 		//Check if object has any of the blocking tags.
-		if(TagContainer.HasAnyExact(TagCDO->BlockingTags))
+		if(FObjectTagRelationshipIndex::HasAnyTagIndex(Relationship.BlockingTags, FoundObject->TagIndices))
 		{
 			return false;
 		}
 
 		//Check if the object has all the required tags.
-		if(!HasRequiredTags(TagRelationship, TagContainer))
+		if(!FObjectTagRelationshipIndex::HasAllTagIndices(Relationship.RequiredTags, FoundObject->TagIndices))
 		{
 			return false;
 		}
 
 		//Remove any tags this relationship wants to remove.
-		RemoveTagsFromObject(TagCDO->RemoveTags, Object, Modifier);
-
-		//Object met requirements, add the tag.
-		AddTagToObject(TagCDO->Tag, Object, Modifier, TagCDO->Value, Duration);
-
-		if(TagCDO->RemoveTagIfAnyBlockingTagIsApplied)
+		if(!Relationship.RemoveTags.IsEmpty())
 		{
-			FoundObject->TagRelationships.Add(TagRelationship);
+			FGameplayTagContainer TagsToRemove;
+			for(const uint16 TagIndex : Relationship.RemoveTags)
+			{
+				TagsToRemove.AddTagFast(FObjectTagIndexTable::Get().GetTag(TagIndex));
+			}
+			RemoveTagsFromObject(TagsToRemove, Object, Modifier);
 		}
-
-		return true;
 	}
-	else
+	else if(!Relationship.RequiredTags.IsEmpty())
 	{
-		FObjectTag NewObjectTag;
-		NewObjectTag.Object = Object;
-		NewObjectTag.TagsAndValues.Add(TagCDO->Tag, TagCDO->Value);
+		//Untracked objects have no tags, so they can't have the required ones.
+		return false;
+	}
 
-		FoundObject->BroadcastTagChange(TagCDO->Tag, Added, Modifier, TagCDO->Value);
-		
-		ObjectTags_Subsystem->ObjectTags.Add(Object, NewObjectTag);
-		return true;
+	//Object met requirements, add the tag.
+	AddTagToObject(RelationshipTag, Object, Modifier, Relationship.Value, Duration);
+
+	if(Relationship.bRemoveTagIfAnyBlockingTagIsApplied && !Relationship.BlockingTags.IsEmpty())
+	{
+		//Adding tags can add or move entries, find it again.
+		if(FObjectTagEntry* ObjectTag = ObjectTags_Subsystem->ObjectTags.Find(Object))
+		{
+			ObjectTag->TagRelationships.AddUnique(TagRelationship);
+		}
 	}
+
+	return true;
 }
 
 bool UObjectTags_Subsystem::RemoveTagsFromObject(FGameplayTagContainer TagsToRemove, UObject* Object, UObject* Modifier)
@@ -332,18 +420,17 @@ bool UObjectTags_Subsystem::RemoveTagsFromObject(FGameplayTagContainer TagsToRem
 
 	bool bTagRemoved = false;
 
-	FObjectTag* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
+	FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
 	if(FoundObject && FoundObject->Object)
 	{
 		for(auto& CurrentTag : TagsToRemove)
 		{
-			if(FoundObject->TagsAndValues.Remove(CurrentTag))
+			if(FoundObject->RemoveTag(CurrentTag))
 			{
+				ObjectTags_Subsystem->RemoveFromReverseIndex(Object, CurrentTag);
+				ObjectTags_Subsystem->ClearTagTimer(Object, CurrentTag);
+				ObjectTags_Subsystem->SyncLooseTags(*FoundObject, {}, MakeArrayView(&CurrentTag, 1));
 				AActor* TargetActor = Cast<AActor>(FoundObject->Object);
-				if(TargetActor)
-				{
-					UAbilitySystemBlueprintLibrary::RemoveLooseGameplayTags(TargetActor, FGameplayTagContainer({CurrentTag}), true);
-				}
 
 				FoundObject->BroadcastTagChange(CurrentTag, Removed, Modifier, 0);
 
@@ -390,10 +477,10 @@ bool UObjectTags_Subsystem::RemoveTagsFromObject(FGameplayTagContainer TagsToRem
 				bTagRemoved = true;
 			}
 			
-			#if WITH_EDITOR
+			#if OBJECTTAGS_WITH_HISTORY
 			if(bTagRemoved && ObjectTags_Subsystem->CollectDebuggingData)
 			{
-				FoundObject->TagHistory.Add(FObjectTagHistory( Modifier ? UKismetSystemLibrary::GetDisplayName(Modifier) : "Invalid Object", CurrentTag, false));
+				FObjectTagHistoryBuffer::Get().Record(Object, FObjectTagIndexTable::Get().FindIndex(CurrentTag), Removed, Modifier);
 			}
 			#endif
 		}
@@ -402,8 +489,9 @@ bool UObjectTags_Subsystem::RemoveTagsFromObject(FGameplayTagContainer TagsToRem
 	if(FoundObject)
 	{
 		//If the object has been destroyed or has no tags AND nobody is listening to it, just remove it.
-		if(!FoundObject->Object.Get() || (FoundObject->TagsAndValues.IsEmpty() && FoundObject->Listeners.IsEmpty()))
+		if(!FoundObject->Object.Get() || (!FoundObject->HasAnyTags() && !FoundObject->HasAnyListeners()))
 		{
+			ObjectTags_Subsystem->RemoveObjectFromReverseIndex(*FoundObject);
 			ObjectTags_Subsystem->ObjectTags.Remove(Object);
 		}
 	}
@@ -411,126 +499,1133 @@ bool UObjectTags_Subsystem::RemoveTagsFromObject(FGameplayTagContainer TagsToRem
 	return bTagRemoved;
 }
 
-bool UObjectTags_Subsystem::DoesObjectHaveTag(FGameplayTag Tag, UObject* Object)
+bool UObjectTags_Subsystem::AddTagsToObjects(FGameplayTagContainer TagsToAdd, TArray<UObject*> Objects, UObject* Modifier, float Value, float Duration)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(DoesObjectHaveTag)
+	TRACE_CPUPROFILER_EVENT_SCOPE(AddTagsToObjects)
 	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
-	if(!ObjectTags_Subsystem)
+	if(!ObjectTags_Subsystem || TagsToAdd.IsEmpty())
 	{
 		return false;
 	}
-	
-	if(FObjectTag* ObjectTags = ObjectTags_Subsystem->ObjectTags.Find(Object))
+
+	//Every mutation is applied first, events are only sent once all objects are up to date.
+	TArray<TPair<UObject*, FObjectTagsDelta>> PendingDeltas;
+	PendingDeltas.Reserve(Objects.Num());
+
+	for(UObject* Object : Objects)
 	{
-		if(ObjectTags->TagsAndValues.Contains(Tag))
+		if(!Object)
 		{
-			return true;
+			continue;
 		}
-	}
 
-	return false;
-}
+		FObjectTagEntry& ObjectTag = ObjectTags_Subsystem->ObjectTags.FindOrAdd(Object);
+		if(!ObjectTag.Object)
+		{
+			ObjectTags_Subsystem->TrackObjectDestruction(Object);
+		}
+		ObjectTag.SetObject(Object, ObjectTags_Subsystem->StateRevision);
 
-float UObjectTags_Subsystem::GetTagValueFromObject(FGameplayTag Tag, UObject* Object)
-{
-	TRACE_CPUPROFILER_EVENT_SCOPE(GetTagValueFromObject)
-	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
-	if(!ObjectTags_Subsystem)
-	{
-		return 0;
+		FObjectTagsDelta Delta;
+		Delta.Value = Value;
+		Delta.Duration = Duration;
+		FGameplayTagContainer NewTags;
+
+		for(const FGameplayTag& CurrentTag : TagsToAdd)
+		{
+			if(!CurrentTag.IsValid())
+			{
+				continue;
+			}
+			
+			if(ObjectTag.SetTag(CurrentTag, Value))
+			{
+				ObjectTags_Subsystem->AddToReverseIndex(Object, CurrentTag);
+				NewTags.AddTagFast(CurrentTag);
+			}
+			Delta.AddedTags.AddTagFast(CurrentTag);
+		}
+
+		//Find every relationship blocked by the new tags and remove their tags in the same pass.
+		FGameplayTagContainer RelationshipTagsToRemove;
+		if(ObjectTag.TagRelationships.IsValidIndex(0) && !NewTags.IsEmpty())
+		{
+			TArray<uint16, TInlineAllocator<16>> NewTagIndices;
+			for(const FGameplayTag& CurrentTag : NewTags)
+			{
+				NewTagIndices.Add(FObjectTagIndexTable::Get().FindIndex(CurrentTag));
+			}
+			ObjectTags_Subsystem->RemoveBlockedRelationships(ObjectTag, NewTagIndices, RelationshipTagsToRemove);
+		}
+
+		for(const FGameplayTag& CurrentTag : RelationshipTagsToRemove)
+		{
+			if(ObjectTag.RemoveTag(CurrentTag))
+			{
+				ObjectTags_Subsystem->RemoveFromReverseIndex(Object, CurrentTag);
+				ObjectTags_Subsystem->ClearTagTimer(Object, CurrentTag);
+				Delta.AddedTags.RemoveTag(CurrentTag);
+				NewTags.RemoveTag(CurrentTag);
+				Delta.RemovedTags.AddTagFast(CurrentTag);
+			}
+		}
+
+		//Sync the ability system once per actor instead of once per tag.
+		ObjectTags_Subsystem->SyncLooseTags(ObjectTag, NewTags.GetGameplayTagArray(), Delta.RemovedTags.GetGameplayTagArray());
+
+		#if OBJECTTAGS_WITH_HISTORY
+		if(ObjectTags_Subsystem->CollectDebuggingData)
+		{
+			FObjectTagHistoryBuffer& History = FObjectTagHistoryBuffer::Get();
+			for(const FGameplayTag& CurrentTag : Delta.AddedTags)
+			{
+				History.Record(Object, FObjectTagIndexTable::Get().FindIndex(CurrentTag), Added, Modifier);
+			}
+			for(const FGameplayTag& CurrentTag : Delta.RemovedTags)
+			{
+				History.Record(Object, FObjectTagIndexTable::Get().FindIndex(CurrentTag), Removed, Modifier);
+			}
+		}
+		#endif
+
+		#if ENABLE_VISUAL_LOG
+		UE_VLOG(ObjectTags_Subsystem, ObjectTagsLog, Verbose, TEXT("Added tags %s to %s, added by %s"), *Delta.AddedTags.ToStringSimple(), *Object->GetName(), *GetNameSafe(Modifier));
+		UE_VLOG_UELOG(ObjectTags_Subsystem, ObjectTagsLog, Verbose, TEXT("Added tags %s to %s, added by %s"), *Delta.AddedTags.ToStringSimple(), *Object->GetName(), *GetNameSafe(Modifier));
+		#endif
+
+		if(Duration > 0)
+		{
+			for(const FGameplayTag& CurrentTag : Delta.AddedTags)
+			{
+				ObjectTags_Subsystem->SetTagTimer(Object, CurrentTag, Modifier, Duration);
+			}
+		}
+
+		PendingDeltas.Emplace(Object, MoveTemp(Delta));
 	}
 
-	if(FObjectTag* ObjectTags = ObjectTags_Subsystem->ObjectTags.Find(Object))
+	//Now that everything is applied, every object and its listeners get a single event.
+	bool bTagAdded = false;
+	for(const TPair<UObject*, FObjectTagsDelta>& CurrentDelta : PendingDeltas)
 	{
-		if(float* Value = ObjectTags->TagsAndValues.Find(Tag))
+		bTagAdded |= !CurrentDelta.Value.AddedTags.IsEmpty();
+		if(FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(CurrentDelta.Key))
 		{
-			return *Value;
+			FoundObject->BroadcastTagsDelta(CurrentDelta.Value, Modifier);
 		}
 	}
 
-	return 0;
+	return bTagAdded;
 }
 
-bool UObjectTags_Subsystem::AddListenerToObject(UObject* Listener, UObject* OtherObject)
+bool UObjectTags_Subsystem::RemoveTagsFromObjects(FGameplayTagContainer TagsToRemove, TArray<UObject*> Objects, UObject* Modifier)
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(RemoveTagsFromObjects)
 	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
-	if(!ObjectTags_Subsystem)
+	if(!ObjectTags_Subsystem || TagsToRemove.IsEmpty())
 	{
 		return false;
 	}
 
-	bool bListenerAdded = false;
+	TArray<TPair<UObject*, FObjectTagsDelta>> PendingDeltas;
+	PendingDeltas.Reserve(Objects.Num());
 
-	FObjectTag* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(OtherObject);
-	if(FoundObject && FoundObject->Object)
+	for(UObject* Object : Objects)
 	{
-		if(!FoundObject->Listeners.Contains(Listener))
+		FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
+		if(!FoundObject || !FoundObject->Object)
 		{
-			FoundObject->Listeners.Add(Listener);
-			bListenerAdded = true;
+			continue;
+		}
+
+		FObjectTagsDelta Delta;
+		for(const FGameplayTag& CurrentTag : TagsToRemove)
+		{
+			if(FoundObject->RemoveTag(CurrentTag))
+			{
+				ObjectTags_Subsystem->RemoveFromReverseIndex(Object, CurrentTag);
+				ObjectTags_Subsystem->ClearTagTimer(Object, CurrentTag);
+				Delta.RemovedTags.AddTagFast(CurrentTag);
+			}
+		}
+
+		if(Delta.IsEmpty())
+		{
+			continue;
+		}
+
+		ObjectTags_Subsystem->SyncLooseTags(*FoundObject, {}, Delta.RemovedTags.GetGameplayTagArray());
+
+		#if OBJECTTAGS_WITH_HISTORY
+		if(ObjectTags_Subsystem->CollectDebuggingData)
+		{
+			FObjectTagHistoryBuffer& History = FObjectTagHistoryBuffer::Get();
+			for(const FGameplayTag& CurrentTag : Delta.RemovedTags)
+			{
+				History.Record(Object, FObjectTagIndexTable::Get().FindIndex(CurrentTag), Removed, Modifier);
+			}
 		}
+		#endif
+
+		#if ENABLE_VISUAL_LOG
+		UE_VLOG(ObjectTags_Subsystem, ObjectTagsLog, Verbose, TEXT("Removed tags %s from %s, removed by %s"), *Delta.RemovedTags.ToStringSimple(), *Object->GetName(), *GetNameSafe(Modifier));
+		UE_VLOG_UELOG(ObjectTags_Subsystem, ObjectTagsLog, Verbose, TEXT("Removed tags %s from %s, removed by %s"), *Delta.RemovedTags.ToStringSimple(), *Object->GetName(), *GetNameSafe(Modifier));
+		#endif
+
+		PendingDeltas.Emplace(Object, MoveTemp(Delta));
 	}
-	else
+
+	for(const TPair<UObject*, FObjectTagsDelta>& CurrentDelta : PendingDeltas)
 	{
-		FObjectTag NewObjectTag;
-		NewObjectTag.Object = OtherObject;
-		NewObjectTag.Listeners.AddUnique(Listener);
-		bListenerAdded = true;
-		ObjectTags_Subsystem->ObjectTags.Add(OtherObject, NewObjectTag);
+		FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(CurrentDelta.Key);
+		if(!FoundObject)
+		{
+			continue;
+		}
+		
+		FoundObject->BroadcastTagsDelta(CurrentDelta.Value, Modifier);
+
+		//Same as RemoveTagsFromObject, drop objects nobody cares about anymore.
+		FoundObject = ObjectTags_Subsystem->ObjectTags.Find(CurrentDelta.Key);
+		if(FoundObject && !FoundObject->HasAnyTags() && !FoundObject->HasAnyListeners())
+		{
+			ObjectTags_Subsystem->ObjectTags.Remove(CurrentDelta.Key);
+		}
 	}
 
-	return bListenerAdded;
+	return !PendingDeltas.IsEmpty();
 }
 
-bool UObjectTags_Subsystem::RemoveListenerForObject(UObject* Listener, UObject* OtherObject)
+bool UObjectTags_Subsystem::DoesObjectHaveTag(FGameplayTag Tag, UObject* Object)
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(DoesObjectHaveTag)
 	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
 	if(!ObjectTags_Subsystem)
 	{
 		return false;
 	}
-
-	FObjectTag* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(OtherObject);
-	if(FoundObject && FoundObject->Object)
+	
+	if(FObjectTagEntry* ObjectTags = ObjectTags_Subsystem->ObjectTags.Find(Object))
 	{
-		if(FoundObject->Listeners.Contains(Listener))
+		if(ObjectTags->HasTag(Tag))
 		{
-			FoundObject->Listeners.Remove(Listener);
 			return true;
-		}		
+		}
 	}
 
 	return false;
 }
 
-void UObjectTags_Subsystem::CleanupObjectTagArray()
+bool UObjectTags_Subsystem::DoesObjectHaveTag_AnyThread(FGameplayTag Tag, const UObject* Object)
+{
+	float Value = 0;
+	return FObjectTagsSnapshot::FindTagValue_AnyThread(Object, Tag, Value);
+}
+
+float UObjectTags_Subsystem::GetTagValueFromObject_AnyThread(FGameplayTag Tag, const UObject* Object)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(CleanupObjectTagArray)
-	TArray<TObjectPtr<UObject>> ObjectArray;
-	ObjectTags.GenerateKeyArray(ObjectArray);
+	float Value = 0;
+	FObjectTagsSnapshot::FindTagValue_AnyThread(Object, Tag, Value);
+	return Value;
+}
 
-	TArray<FObjectTag> TagsArray;
-	ObjectTags.GenerateValueArray(TagsArray);
+TArray<FObjectTagHistory> UObjectTags_Subsystem::GetObjectTagHistory(UObject* Object)
+{
+	TArray<FObjectTagHistory> History;
 	
-	for(int32 CurrentObject = 0; CurrentObject < ObjectArray.Num(); CurrentObject++)
+#if OBJECTTAGS_WITH_HISTORY
+	if(!Object)
 	{
-		//If an object still has a listener, we do not want to remove the object. Only if an object has no
-		//tags and has no listener, then remove it, even though the object is valid.
-		if(!ObjectArray[CurrentObject].Get() || (TagsArray[CurrentObject].TagsAndValues.IsEmpty() && TagsArray[CurrentObject].Listeners.IsEmpty()))
-		{
-			ObjectTags.Remove(ObjectArray[CurrentObject]);
-			ObjectArray.RemoveAt(CurrentObject);
-			TagsArray.RemoveAt(CurrentObject);
-			CurrentObject--;
-		}
+		return History;
+	}
+	
+	TArray<FObjectTagHistoryRecord> Records;
+	FObjectTagHistoryBuffer::Get().GetRecords(Records, Object);
+	
+	History.Reserve(Records.Num());
+	for(const FObjectTagHistoryRecord& CurrentRecord : Records)
+	{
+		const UObject* Modifier = CurrentRecord.Modifier.ResolveObjectPtr();
+		
+		FObjectTagHistory& Entry = History.AddDefaulted_GetRef();
+		Entry.Modifier = Modifier ? UKismetSystemLibrary::GetDisplayName(Modifier) : TEXT("Invalid Object");
+		Entry.TagsModified = FObjectTagIndexTable::Get().GetTag(CurrentRecord.TagIndex);
+		Entry.Added = CurrentRecord.Modification == Added;
+		Entry.Time = CurrentRecord.Time;
 	}
+#endif
+	
+	return History;
 }
 
-FGameplayTagContainer UObjectTags_Subsystem::GetConflictingTags(TSubclassOf<UO_TagRelationship> Relationship, FGameplayTagContainer Container)
+float UObjectTags_Subsystem::GetTagRemainingTime(FGameplayTag Tag, UObject* Object)
 {
-	FGameplayTagContainer TagsToRemove;
-
-	for(auto& CurrentTag : Container)
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem || !Object)
+	{
+		return -1;
+	}
+
+	return ObjectTags_Subsystem->TagExpiryScheduler.GetRemainingTime(Object, FObjectTagIndexTable::Get().FindIndex(Tag));
+}
+
+float UObjectTags_Subsystem::GetTagValueFromObject(FGameplayTag Tag, UObject* Object)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(GetTagValueFromObject)
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem)
+	{
+		return 0;
+	}
+
+	if(FObjectTagEntry* ObjectTags = ObjectTags_Subsystem->ObjectTags.Find(Object))
+	{
+		if(const float* Value = ObjectTags->FindValue(Tag))
+		{
+			return *Value;
+		}
+	}
+
+	return 0;
+}
+
+TArray<UObject*> UObjectTags_Subsystem::GetObjectsWithTag(FGameplayTag Tag, bool ExactMatch)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(GetObjectsWithTag)
+	TArray<UObject*> FoundObjects;
+	
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem)
+	{
+		return FoundObjects;
+	}
+
+	const FObjectTagReverseIndexEntry* Entry = ObjectTags_Subsystem->FindReverseIndexEntry(Tag);
+	if(!Entry)
+	{
+		return FoundObjects;
+	}
+
+	if(ExactMatch)
+	{
+		FoundObjects.Reserve(Entry->ExactObjects.Num());
+		for(const TWeakObjectPtr<UObject>& CurrentObject : Entry->ExactObjects)
+		{
+			if(UObject* Object = CurrentObject.Get())
+			{
+				FoundObjects.Add(Object);
+			}
+		}
+	}
+	else
+	{
+		FoundObjects.Reserve(Entry->HierarchyObjects.Num());
+		for(const auto& CurrentObject : Entry->HierarchyObjects)
+		{
+			if(UObject* Object = CurrentObject.Key.Get())
+			{
+				FoundObjects.Add(Object);
+			}
+		}
+	}
+
+	return FoundObjects;
+}
+
+TArray<UObject*> UObjectTags_Subsystem::GetObjectsWithAnyTags(FGameplayTagContainer Tags, bool ExactMatch)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(GetObjectsWithAnyTags)
+	if(Tags.Num() == 1)
+	{
+		return GetObjectsWithTag(Tags.First(), ExactMatch);
+	}
+
+	TSet<UObject*> FoundObjects;
+	for(const FGameplayTag& CurrentTag : Tags)
+	{
+		FoundObjects.Append(GetObjectsWithTag(CurrentTag, ExactMatch));
+	}
+
+	return FoundObjects.Array();
+}
+
+TArray<UObject*> UObjectTags_Subsystem::GetObjectsWithAllTags(FGameplayTagContainer Tags, bool ExactMatch)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(GetObjectsWithAllTags)
+	TArray<UObject*> FoundObjects;
+	
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem || Tags.IsEmpty())
+	{
+		return FoundObjects;
+	}
+
+	//Gather the entry of every tag, bailing out early if any tag has no objects at all.
+	TArray<const FObjectTagReverseIndexEntry*, TInlineAllocator<8>> Entries;
+	for(const FGameplayTag& CurrentTag : Tags)
+	{
+		const FObjectTagReverseIndexEntry* Entry = ObjectTags_Subsystem->FindReverseIndexEntry(CurrentTag);
+		if(!Entry)
+		{
+			return FoundObjects;
+		}
+		Entries.Add(Entry);
+	}
+
+	auto GetEntryNum = [ExactMatch](const FObjectTagReverseIndexEntry* Entry)
+	{
+		return ExactMatch ? Entry->ExactObjects.Num() : Entry->HierarchyObjects.Num();
+	};
+
+	auto EntryContains = [ExactMatch](const FObjectTagReverseIndexEntry* Entry, const TWeakObjectPtr<UObject>& Object)
+	{
+		return ExactMatch ? Entry->ExactObjects.Contains(Object) : Entry->HierarchyObjects.Contains(Object);
+	};
+
+	//Walk the smallest entry and check the others, so the cost follows the smallest result.
+	Entries.Sort([&GetEntryNum](const FObjectTagReverseIndexEntry& A, const FObjectTagReverseIndexEntry& B)
+	{
+		return GetEntryNum(&A) < GetEntryNum(&B);
+	});
+
+	auto TryAddObject = [&](const TWeakObjectPtr<UObject>& CurrentObject)
+	{
+		UObject* Object = CurrentObject.Get();
+		if(!Object)
+		{
+			return;
+		}
+		
+		for(int32 CurrentEntry = 1; CurrentEntry < Entries.Num(); CurrentEntry++)
+		{
+			if(!EntryContains(Entries[CurrentEntry], CurrentObject))
+			{
+				return;
+			}
+		}
+		FoundObjects.Add(Object);
+	};
+
+	if(ExactMatch)
+	{
+		for(const TWeakObjectPtr<UObject>& CurrentObject : Entries[0]->ExactObjects)
+		{
+			TryAddObject(CurrentObject);
+		}
+	}
+	else
+	{
+		for(const auto& CurrentObject : Entries[0]->HierarchyObjects)
+		{
+			TryAddObject(CurrentObject.Key);
+		}
+	}
+
+	return FoundObjects;
+}
+
+bool UObjectTags_Subsystem::AddListenerToObject(UObject* Listener, UObject* OtherObject)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem)
+	{
+		return false;
+	}
+
+	bool bListenerAdded = false;
+
+	FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(OtherObject);
+	if(FoundObject && FoundObject->Object)
+	{
+		if(!FoundObject->ListenerEntries.Contains(Listener))
+		{
+			FoundObject->ListenerEntries.Add(FObjectTagListener(Listener));
+			bListenerAdded = true;
+		}
+	}
+	else
+	{
+		FObjectTagEntry NewObjectTag;
+		NewObjectTag.SetObject(OtherObject, ObjectTags_Subsystem->StateRevision);
+		NewObjectTag.ListenerEntries.AddUnique(FObjectTagListener(Listener));
+		bListenerAdded = true;
+		ObjectTags_Subsystem->ObjectTags.Add(OtherObject, NewObjectTag);
+		ObjectTags_Subsystem->TrackObjectDestruction(OtherObject);
+	}
+
+	return bListenerAdded;
+}
+
+bool UObjectTags_Subsystem::RemoveListenerForObject(UObject* Listener, UObject* OtherObject)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem)
+	{
+		return false;
+	}
+
+	FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(OtherObject);
+	if(FoundObject && FoundObject->Object)
+	{
+		if(FoundObject->ListenerEntries.RemoveAll([Listener](const FObjectTagListener& CurrentListener) { return CurrentListener.Listener == Listener; }) > 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool UObjectTags_Subsystem::AddTagListenerToObject(UObject* Listener, UObject* OtherObject, FGameplayTag Tag, bool ExactMatch)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem || !Listener || !OtherObject || !Tag.IsValid())
+	{
+		return false;
+	}
+
+	FObjectTagEntry& FoundObject = ObjectTags_Subsystem->FindOrAddObjectTag(OtherObject);
+	TArray<FObjectTagSubscription>& Subscriptions = FoundObject.GetOrAddSubscriptions().TagSubscriptions.FindOrAdd(FObjectTagIndexTable::Get().FindOrAddIndex(Tag));
+	for(FObjectTagSubscription& CurrentSubscription : Subscriptions)
+	{
+		if(CurrentSubscription.Listener == Listener && !CurrentSubscription.Delegate.IsBound() && !CurrentSubscription.bRemoved)
+		{
+			CurrentSubscription.bExactMatch = ExactMatch;
+			return false;
+		}
+	}
+
+	FObjectTagSubscription& NewSubscription = Subscriptions.AddDefaulted_GetRef();
+	NewSubscription.Listener = Listener;
+	NewSubscription.bImplementsInterface = DoesObjectImplementTagsCommunication(Listener);
+	NewSubscription.Handle = FDelegateHandle(FDelegateHandle::GenerateNewHandle);
+	NewSubscription.bExactMatch = ExactMatch;
+	return true;
+}
+
+bool UObjectTags_Subsystem::RemoveTagListenerForObject(UObject* Listener, UObject* OtherObject, FGameplayTag Tag)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem)
+	{
+		return false;
+	}
+
+	FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(OtherObject);
+	if(!FoundObject)
+	{
+		return false;
+	}
+
+	if(!FoundObject->Subscribers.IsValid())
+	{
+		return false;
+	}
+
+	const uint16 TagIndex = FObjectTagIndexTable::Get().FindIndex(Tag);
+	TArray<FObjectTagSubscription>* Subscriptions = FoundObject->Subscribers->TagSubscriptions.Find(TagIndex);
+	if(!Subscriptions)
+	{
+		return false;
+	}
+
+	const int32 RemovedCount = ObjectTags_Subsystem->RemoveSubscriptions(OtherObject, *Subscriptions, [Listener](const FObjectTagSubscription& CurrentSubscription)
+	{
+		return CurrentSubscription.Listener == Listener && !CurrentSubscription.Delegate.IsBound();
+	});
+
+	if(Subscriptions->IsEmpty())
+	{
+		FoundObject->Subscribers->TagSubscriptions.Remove(TagIndex);
+		FoundObject->ReleaseEmptySubscriptions();
+	}
+
+	return RemovedCount > 0;
+}
+
+FDelegateHandle UObjectTags_Subsystem::SubscribeToTag(UObject* Object, FGameplayTag Tag, FOnObjectTagChanged Delegate, bool ExactMatch)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem || !Object || !Tag.IsValid() || !Delegate.IsBound())
+	{
+		return FDelegateHandle();
+	}
+
+	FObjectTagEntry& FoundObject = ObjectTags_Subsystem->FindOrAddObjectTag(Object);
+	FObjectTagSubscription& NewSubscription = FoundObject.GetOrAddSubscriptions().TagSubscriptions.FindOrAdd(FObjectTagIndexTable::Get().FindOrAddIndex(Tag)).AddDefaulted_GetRef();
+	NewSubscription.Delegate = MoveTemp(Delegate);
+	NewSubscription.Handle = FDelegateHandle(FDelegateHandle::GenerateNewHandle);
+	NewSubscription.bExactMatch = ExactMatch;
+	return NewSubscription.Handle;
+}
+
+FDelegateHandle UObjectTags_Subsystem::SubscribeToTagQuery(UObject* Object, const FGameplayTagQuery& TagQuery, FOnObjectTagChanged Delegate)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem || !Object || TagQuery.IsEmpty() || !Delegate.IsBound())
+	{
+		return FDelegateHandle();
+	}
+
+	FObjectTagEntry& FoundObject = ObjectTags_Subsystem->FindOrAddObjectTag(Object);
+	FObjectTagSubscription& NewSubscription = FoundObject.GetOrAddSubscriptions().QuerySubscriptions.AddDefaulted_GetRef();
+	NewSubscription.Delegate = MoveTemp(Delegate);
+	NewSubscription.TagQuery = TagQuery;
+	NewSubscription.Handle = FDelegateHandle(FDelegateHandle::GenerateNewHandle);
+	return NewSubscription.Handle;
+}
+
+bool UObjectTags_Subsystem::UnsubscribeFromObject(UObject* Object, FDelegateHandle Handle)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!ObjectTags_Subsystem || !Handle.IsValid())
+	{
+		return false;
+	}
+
+	FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(Object);
+	if(!FoundObject || !FoundObject->Subscribers.IsValid())
+	{
+		return false;
+	}
+
+	auto MatchesHandle = [Handle](const FObjectTagSubscription& CurrentSubscription)
+	{
+		return CurrentSubscription.Handle == Handle;
+	};
+
+	if(ObjectTags_Subsystem->RemoveSubscriptions(Object, FoundObject->Subscribers->QuerySubscriptions, MatchesHandle) > 0)
+	{
+		FoundObject->ReleaseEmptySubscriptions();
+		return true;
+	}
+
+	for(auto It = FoundObject->Subscribers->TagSubscriptions.CreateIterator(); It; ++It)
+	{
+		if(ObjectTags_Subsystem->RemoveSubscriptions(Object, It.Value(), MatchesHandle) > 0)
+		{
+			if(It.Value().IsEmpty())
+			{
+				It.RemoveCurrent();
+				FoundObject->ReleaseEmptySubscriptions();
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int32 UObjectTags_Subsystem::RemoveSubscriptions(UObject* Object, TArray<FObjectTagSubscription>& Subscriptions, TFunctionRef<bool(const FObjectTagSubscription&)> Predicate)
+{
+	if(SubscriptionNotifyDepth == 0)
+	{
+		return Subscriptions.RemoveAll([&Predicate](const FObjectTagSubscription& CurrentSubscription)
+		{
+			return Predicate(CurrentSubscription);
+		});
+	}
+
+	int32 RemovedCount = 0;
+	for(FObjectTagSubscription& CurrentSubscription : Subscriptions)
+	{
+		if(!CurrentSubscription.bRemoved && Predicate(CurrentSubscription))
+		{
+			CurrentSubscription.bRemoved = true;
+			RemovedCount++;
+		}
+	}
+
+	if(RemovedCount > 0)
+	{
+		ObjectsWithRemovedSubscriptions.AddUnique(Object);
+	}
+	return RemovedCount;
+}
+
+void UObjectTags_Subsystem::PurgeRemovedSubscriptions()
+{
+	auto IsRemoved = [](const FObjectTagSubscription& CurrentSubscription)
+	{
+		return CurrentSubscription.bRemoved;
+	};
+
+	for(const TWeakObjectPtr<UObject>& CurrentObject : ObjectsWithRemovedSubscriptions)
+	{
+		FObjectTagEntry* FoundObject = ObjectTags.Find(CurrentObject.Get());
+		if(!FoundObject || !FoundObject->Subscribers.IsValid())
+		{
+			continue;
+		}
+
+		FoundObject->Subscribers->QuerySubscriptions.RemoveAll(IsRemoved);
+		for(auto It = FoundObject->Subscribers->TagSubscriptions.CreateIterator(); It; ++It)
+		{
+			It.Value().RemoveAll(IsRemoved);
+			if(It.Value().IsEmpty())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		FoundObject->ReleaseEmptySubscriptions();
+	}
+
+	ObjectsWithRemovedSubscriptions.Reset();
+}
+
+void FObjectTagEntry::NotifySubscriptions(UObject* OwningObject, const FObjectTagSubscriptionArray& Subscriptions, ETagModification Modification,
+	UObject* Modifier, float Value, float Duration)
+{
+	UObjectTags_Subsystem* ObjectTags_Subsystem = UObjectTags_Subsystem::Get();
+	if(Subscriptions.IsEmpty() || !ObjectTags_Subsystem)
+	{
+		return;
+	}
+
+	ObjectTags_Subsystem->SubscriptionNotifyDepth++;
+	for(const FObjectTagSubscriptionRef& CurrentReference : Subscriptions)
+	{
+		const FObjectTagEntry* FoundObject = ObjectTags_Subsystem->ObjectTags.Find(OwningObject);
+		if(const FObjectTagSubscription* Subscription = FoundObject ? FoundObject->FindSubscription(CurrentReference) : nullptr)
+		{
+			Subscription->Notify(CurrentReference.Tag, Modification, OwningObject, Modifier, Value, Duration);
+		}
+	}
+
+	if(--ObjectTags_Subsystem->SubscriptionNotifyDepth == 0 && !ObjectTags_Subsystem->ObjectsWithRemovedSubscriptions.IsEmpty())
+	{
+		ObjectTags_Subsystem->PurgeRemovedSubscriptions();
+	}
+}
+
+FObjectTagEntry& UObjectTags_Subsystem::FindOrAddObjectTag(UObject* Object)
+{
+	if(FObjectTagEntry* FoundObject = ObjectTags.Find(Object))
+	{
+		return *FoundObject;
+	}
+
+	FObjectTagEntry NewObjectTag;
+	NewObjectTag.SetObject(Object, StateRevision);
+	TrackObjectDestruction(Object);
+	return ObjectTags.Add(Object, NewObjectTag);
+}
+
+#if WITH_EDITOR
+void UObjectTags_Subsystem::OnObjectsReplaced(const TMap<UObject*, UObject*>& ReplacementMap)
+{
+	//Relationship classes might have been recompiled, re-index them as they're used.
+	FObjectTagRelationshipIndex::Get().Reset();
+	
+	//Blueprint recompiles can add or remove the interface, so every cached check is stale.
+	for(TPair<TObjectPtr<UObject>, FObjectTagEntry>& CurrentObject : ObjectTags)
+	{
+		for(FObjectTagListener& CurrentListener : CurrentObject.Value.ListenerEntries)
+		{
+			if(UObject* const* Replacement = ReplacementMap.Find(CurrentListener.Listener))
+			{
+				CurrentListener.Listener = *Replacement;
+			}
+		}
+		
+		CurrentObject.Value.RefreshInterfaceCache();
+	}
+}
+#endif
+
+UAbilitySystemComponent* UObjectTags_Subsystem::FindAbilitySystemComponent(FObjectTagEntry& ObjectTag, bool& bOutNewlyResolved)
+{
+	bOutNewlyResolved = false;
+	if(UAbilitySystemComponent* AbilitySystemComponent = ObjectTag.CachedAbilitySystemComponent.Get())
+	{
+		return AbilitySystemComponent;
+	}
+
+	//Only actors can have an ability system. Actors without one are checked again
+	//next frame, their ability system might be set up after their first tag (possession for example).
+	AActor* TargetActor = Cast<AActor>(ObjectTag.Object.Get());
+	if(!TargetActor || ObjectTag.AbilitySystemResolveFrame == GFrameCounter)
+	{
+		return nullptr;
+	}
+
+	ObjectTag.AbilitySystemResolveFrame = GFrameCounter;
+	UAbilitySystemComponent* AbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(TargetActor);
+	ObjectTag.CachedAbilitySystemComponent = AbilitySystemComponent;
+	bOutNewlyResolved = AbilitySystemComponent != nullptr;
+	return AbilitySystemComponent;
+}
+
+void UObjectTags_Subsystem::SyncLooseTags(FObjectTagEntry& ObjectTag, TConstArrayView<FGameplayTag> AddedTags, TConstArrayView<FGameplayTag> RemovedTags)
+{
+	if(AddedTags.IsEmpty() && RemovedTags.IsEmpty())
+	{
+		return;
+	}
+	
+	bool bNewlyResolved = false;
+	UAbilitySystemComponent* AbilitySystemComponent = FindAbilitySystemComponent(ObjectTag, bNewlyResolved);
+	if(!AbilitySystemComponent)
+	{
+		return;
+	}
+
+	//Tags from before the ability system existed never reached it. The objects
+	//tags already contain the @AddedTags, so sending all of them covers this change too.
+	if(bNewlyResolved)
+	{
+		CatchUpLooseTags(ObjectTag, AbilitySystemComponent, RemovedTags);
+		return;
+	}
+
+	QueueLooseTags(AbilitySystemComponent, AddedTags, RemovedTags);
+}
+
+void UObjectTags_Subsystem::CatchUpLooseTags(const FObjectTagEntry& ObjectTag, UAbilitySystemComponent* AbilitySystemComponent, TConstArrayView<FGameplayTag> IgnoredTags)
+{
+	const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	TArray<FGameplayTag, TInlineAllocator<16>> CurrentTags;
+	for(const uint16 TagIndex : ObjectTag.TagIndices)
+	{
+		const FGameplayTag CurrentTag = IndexTable.GetTag(TagIndex);
+		if(!IgnoredTags.Contains(CurrentTag))
+		{
+			CurrentTags.Add(CurrentTag);
+		}
+	}
+
+	if(!CurrentTags.IsEmpty())
+	{
+		QueueLooseTags(AbilitySystemComponent, CurrentTags, {});
+	}
+}
+
+void UObjectTags_Subsystem::QueueLooseTags(UAbilitySystemComponent* AbilitySystemComponent, TConstArrayView<FGameplayTag> AddedTags, TConstArrayView<FGameplayTag> RemovedTags)
+{
+	if(CVarObjectTagsDeferAbilitySystemSync.GetValueOnGameThread())
+	{
+		//Net count per tag, so a tag that is added and removed in the same frame never reaches the ability system.
+		TMap<FGameplayTag, int32>& PendingTags = PendingLooseTags.FindOrAdd(AbilitySystemComponent);
+		for(const FGameplayTag& CurrentTag : AddedTags)
+		{
+			PendingTags.FindOrAdd(CurrentTag)++;
+		}
+		for(const FGameplayTag& CurrentTag : RemovedTags)
+		{
+			PendingTags.FindOrAdd(CurrentTag)--;
+		}
+		return;
+	}
+
+	ApplyLooseTags(AbilitySystemComponent, AddedTags, RemovedTags);
+}
+
+void UObjectTags_Subsystem::ApplyLooseTags(UAbilitySystemComponent* AbilitySystemComponent, TConstArrayView<FGameplayTag> AddedTags, TConstArrayView<FGameplayTag> RemovedTags)
+{
+	//Owned tags are read through the reference, no copy of every tag on the ability system.
+	const FGameplayTagContainer& OwnedTags = AbilitySystemComponent->GetOwnedGameplayTags();
+	
+	FGameplayTagContainer LooseTagsToAdd;
+	for(const FGameplayTag& CurrentTag : AddedTags)
+	{
+		if(!OwnedTags.HasTagExact(CurrentTag))
+		{
+			LooseTagsToAdd.AddTagFast(CurrentTag);
+		}
+	}
+
+	if(!LooseTagsToAdd.IsEmpty())
+	{
+		AbilitySystemComponent->AddLooseGameplayTags(LooseTagsToAdd);
+		AbilitySystemComponent->AddReplicatedLooseGameplayTags(LooseTagsToAdd);
+	}
+
+	if(!RemovedTags.IsEmpty())
+	{
+		const FGameplayTagContainer LooseTagsToRemove = FGameplayTagContainer::CreateFromArray(TArray<FGameplayTag>(RemovedTags));
+		AbilitySystemComponent->RemoveLooseGameplayTags(LooseTagsToRemove);
+		AbilitySystemComponent->RemoveReplicatedLooseGameplayTags(LooseTagsToRemove);
+	}
+}
+
+void UObjectTags_Subsystem::FlushLooseTags()
+{
+	if(PendingLooseTags.IsEmpty())
+	{
+		return;
+	}
+	
+	TRACE_CPUPROFILER_EVENT_SCOPE(FlushLooseTags)
+	TArray<FGameplayTag, TInlineAllocator<16>> AddedTags;
+	TArray<FGameplayTag, TInlineAllocator<16>> RemovedTags;
+	for(const TPair<TWeakObjectPtr<UAbilitySystemComponent>, TMap<FGameplayTag, int32>>& CurrentComponent : PendingLooseTags)
+	{
+		UAbilitySystemComponent* AbilitySystemComponent = CurrentComponent.Key.Get();
+		if(!AbilitySystemComponent)
+		{
+			continue;
+		}
+
+		AddedTags.Reset();
+		RemovedTags.Reset();
+		for(const TPair<FGameplayTag, int32>& CurrentTag : CurrentComponent.Value)
+		{
+			if(CurrentTag.Value > 0)
+			{
+				AddedTags.Add(CurrentTag.Key);
+			}
+			else if(CurrentTag.Value < 0)
+			{
+				RemovedTags.Add(CurrentTag.Key);
+			}
+		}
+
+		ApplyLooseTags(AbilitySystemComponent, AddedTags, RemovedTags);
+	}
+
+	PendingLooseTags.Reset();
+}
+
+void UObjectTags_Subsystem::TrackObjectDestruction(UObject* Object)
+{
+	//Actors tell us when they die, so they never have to wait for the sweep.
+	if(AActor* Actor = Cast<AActor>(Object))
+	{
+		Actor->OnDestroyed.AddUniqueDynamic(this, &UObjectTags_Subsystem::OnTrackedActorDestroyed);
+	}
+}
+
+void UObjectTags_Subsystem::OnTrackedActorDestroyed(AActor* DestroyedActor)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(OnTrackedActorDestroyed)
+	const FSetElementId ObjectId = ObjectTags.FindId(DestroyedActor);
+	if(!ObjectTags.IsValidId(ObjectId))
+	{
+		return;
+	}
+
+	//Timers and the reverse index are keyed on the actor, so clean those up while it can still be found.
+	FObjectTagEntry& ObjectTag = ObjectTags.Get(ObjectId).Value;
+	TagExpiryScheduler.CancelObject(ObjectTag.WeakObject, ObjectTag.TagIndices);
+	RemoveObjectFromReverseIndex(ObjectTag);
+
+	//Callers further up the stack can still be holding on to this entry, so it can't be removed yet.
+	if(!ObjectTag.bPendingRemoval)
+	{
+		ObjectTag.bPendingRemoval = true;
+		PendingRemovals.Add(ObjectId);
+	}
+}
+
+void UObjectTags_Subsystem::ReclaimDestroyedObjects()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ReclaimDestroyedObjects)
+	for(const FSetElementId ObjectId : PendingRemovals)
+	{
+		//The sweep might have removed it already, and something else could be using the id since.
+		if(!ObjectTags.IsValidId(ObjectId) || !ObjectTags.Get(ObjectId).Value.bPendingRemoval)
+		{
+			continue;
+		}
+
+		//Anything added after the actor was destroyed still has to go.
+		const FObjectTagEntry& ObjectTag = ObjectTags.Get(ObjectId).Value;
+		TagExpiryScheduler.CancelObject(ObjectTag.WeakObject, ObjectTag.TagIndices);
+
+		RemoveObjectFromReverseIndex(ObjectTag);
+		ObjectTags.Remove(ObjectId);
+		StateRevision++;
+		ReclaimedThisFrame++;
+	}
+	PendingRemovals.Reset();
+}
+
+void UObjectTags_Subsystem::SweepStaleObjects(int32 Budget)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(SweepStaleObjects)
+
+	//Walk the map a few slots at a time, picking up where the last frame stopped.
+	//Removing by id leaves a hole in the set instead of moving other entries,
+	//so the cursor stays valid between frames.
+	const int32 MaxIndex = ObjectTags.GetMaxIndex();
+	const int32 SlotsToVisit = FMath::Min(FMath::Max(Budget, 0), MaxIndex);
+	int32 SlotsVisited = 0;
+	for(; SlotsVisited < SlotsToVisit; SlotsVisited++)
+	{
+		if(SweepCursor >= MaxIndex)
+		{
+			SweepCursor = 0;
+		}
+		
+		const FSetElementId ObjectId = FSetElementId::FromInteger(SweepCursor++);
+		if(!ObjectTags.IsValidId(ObjectId))
+		{
+			continue;
+		}
+
+		//If an object still has a listener, we do not want to remove the object. Only if an object has no
+		//tags and has no listener, then remove it, even though the object is valid.
+		const TPair<TObjectPtr<UObject>, FObjectTagEntry>& CurrentObject = ObjectTags.Get(ObjectId);
+		if(IsValid(CurrentObject.Value.Object) && !CurrentObject.Value.bPendingRemoval
+			&& (CurrentObject.Value.HasAnyTags() || CurrentObject.Value.HasAnyListeners()))
+		{
+			//Ability systems can be created after the first tags were added, a player state one for
+			//example. Look again here, so those tags reach it without waiting for the next tag change.
+			FObjectTagEntry& KeptObject = ObjectTags.Get(ObjectId).Value;
+			if(KeptObject.HasAnyTags() && !KeptObject.CachedAbilitySystemComponent.IsValid())
+			{
+				bool bNewlyResolved = false;
+				UAbilitySystemComponent* AbilitySystemComponent = FindAbilitySystemComponent(KeptObject, bNewlyResolved);
+				if(bNewlyResolved)
+				{
+					CatchUpLooseTags(KeptObject, AbilitySystemComponent, {});
+				}
+			}
+			continue;
+		}
+
+		//The object is usually gone by now, so its timers are cancelled through the weak pointer.
+		TagExpiryScheduler.CancelObject(CurrentObject.Value.WeakObject, CurrentObject.Value.TagIndices);
+		RemoveObjectFromReverseIndex(CurrentObject.Value);
+		ObjectTags.Remove(ObjectId);
+		StateRevision++;
+		ReclaimedThisFrame++;
+	}
+
+	SET_DWORD_STAT(STAT_ObjectTagsEntriesSwept, SlotsVisited);
+	SET_DWORD_STAT(STAT_ObjectTagsEntriesReclaimed, ReclaimedThisFrame);
+	ReclaimedThisFrame = 0;
+}
+
+void UObjectTags_Subsystem::AddToReverseIndex(UObject* Object, FGameplayTag Tag)
+{
+	const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	const uint16 TagIndex = IndexTable.FindIndex(Tag);
+	if(TagIndex == FObjectTagIndexTable::InvalidIndex)
+	{
+		return;
+	}
+
+	if(TagReverseIndex.Num() < IndexTable.Num())
+	{
+		TagReverseIndex.SetNum(IndexTable.Num());
+	}
+
+	const TWeakObjectPtr<UObject> ObjectKey(Object);
+	TagReverseIndex[TagIndex].ExactObjects.Add(ObjectKey);
+
+	//Count the tag towards itself and every parent, this is what makes hierarchy queries a single lookup.
+	for(uint16 CurrentIndex = TagIndex; CurrentIndex != FObjectTagIndexTable::InvalidIndex; CurrentIndex = IndexTable.GetParentIndex(CurrentIndex))
+	{
+		TagReverseIndex[CurrentIndex].HierarchyObjects.FindOrAdd(ObjectKey, 0)++;
+	}
+}
+
+void UObjectTags_Subsystem::RemoveFromReverseIndex(UObject* Object, FGameplayTag Tag)
+{
+	const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	const uint16 TagIndex = IndexTable.FindIndex(Tag);
+	if(!TagReverseIndex.IsValidIndex(TagIndex))
+	{
+		return;
+	}
+
+	const TWeakObjectPtr<UObject> ObjectKey(Object);
+	TagReverseIndex[TagIndex].ExactObjects.Remove(ObjectKey);
+
+	for(uint16 CurrentIndex = TagIndex; CurrentIndex != FObjectTagIndexTable::InvalidIndex; CurrentIndex = IndexTable.GetParentIndex(CurrentIndex))
+	{
+		TMap<TWeakObjectPtr<UObject>, int32>& HierarchyObjects = TagReverseIndex[CurrentIndex].HierarchyObjects;
+		if(int32* Count = HierarchyObjects.Find(ObjectKey))
+		{
+			if(--(*Count) <= 0)
+			{
+				HierarchyObjects.Remove(ObjectKey);
+			}
+		}
+	}
+}
+
+void UObjectTags_Subsystem::RemoveObjectFromReverseIndex(const FObjectTagEntry& ObjectTag)
+{
+	//Weak pointers compare by index and serial number, so this is the same key
+	//the object was added with, even if the garbage collector already nulled it.
+	const TWeakObjectPtr<UObject>& Object = ObjectTag.WeakObject;
+	const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	for(const uint16 TagIndex : ObjectTag.TagIndices)
+	{
+		if(!TagReverseIndex.IsValidIndex(TagIndex))
+		{
+			continue;
+		}
+		
+		TagReverseIndex[TagIndex].ExactObjects.Remove(Object);
+		for(uint16 CurrentIndex = TagIndex; CurrentIndex != FObjectTagIndexTable::InvalidIndex; CurrentIndex = IndexTable.GetParentIndex(CurrentIndex))
+		{
+			TagReverseIndex[CurrentIndex].HierarchyObjects.Remove(Object);
+		}
+	}
+}
+
+const FObjectTagReverseIndexEntry* UObjectTags_Subsystem::FindReverseIndexEntry(FGameplayTag Tag) const
+{
+	const uint16 TagIndex = FObjectTagIndexTable::Get().FindIndex(Tag);
+	return TagReverseIndex.IsValidIndex(TagIndex) ? &TagReverseIndex[TagIndex] : nullptr;
+}
+
+void UObjectTags_Subsystem::SetTagTimer(UObject* Object, FGameplayTag Tag, UObject* Modifier, float Duration)
+{
+	const uint16 TagIndex = FObjectTagIndexTable::Get().FindIndex(Tag);
+	if(TagIndex == FObjectTagIndexTable::InvalidIndex)
+	{
+		return;
+	}
+	
+	//Scheduling a tag that is already scheduled refreshes its duration.
+	TagExpiryScheduler.Schedule(Object, TagIndex, Modifier, Duration);
+}
+
+void UObjectTags_Subsystem::ClearTagTimer(UObject* Object, FGameplayTag Tag)
+{
+	const uint16 TagIndex = FObjectTagIndexTable::Get().FindIndex(Tag);
+	if(TagIndex != FObjectTagIndexTable::InvalidIndex)
+	{
+		TagExpiryScheduler.Cancel(Object, TagIndex);
+	}
+}
+
+void UObjectTags_Subsystem::ExpireTags(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ExpireTags)
+	TArray<FObjectTagExpiryScheduler::FExpiredTag> ExpiredTags;
+	TagExpiryScheduler.Advance(DeltaTime, ExpiredTags);
+	if(ExpiredTags.IsEmpty())
+	{
+		return;
+	}
+
+	//Group the expired tags, so every object and modifier pair gets a single removal.
+	const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	TMap<TPair<UObject*, UObject*>, FGameplayTagContainer> TagsToRemove;
+	for(const FObjectTagExpiryScheduler::FExpiredTag& CurrentTag : ExpiredTags)
+	{
+		if(UObject* Object = CurrentTag.Object.Get())
+		{
+			TagsToRemove.FindOrAdd(TPair<UObject*, UObject*>(Object, CurrentTag.Modifier.Get())).AddTagFast(IndexTable.GetTag(CurrentTag.TagIndex));
+		}
+	}
+
+	for(const auto& CurrentRemoval : TagsToRemove)
+	{
+		RemoveTagsFromObject(CurrentRemoval.Value, CurrentRemoval.Key.Key, CurrentRemoval.Key.Value);
+	}
+}
+
+FGameplayTagContainer UObjectTags_Subsystem::GetConflictingTags(TSubclassOf<UO_TagRelationship> Relationship, FGameplayTagContainer Container)
+{
+	FGameplayTagContainer TagsToRemove;
+
+	for(auto& CurrentTag : Container)
 	{
 		if(Relationship.GetDefaultObject()->RemoveTags.HasTagExact(CurrentTag))
 		{
@@ -557,12 +1652,85 @@ FGameplayTagContainer UObjectTags_Subsystem::GetBlockingTags(TSubclassOf<UO_TagR
 	return BlockingTags;
 }
 
+void UObjectTags_Subsystem::RemoveBlockedRelationships(FObjectTagEntry& ObjectTag, TConstArrayView<uint16> NewTagIndices, FGameplayTagContainer& OutTagsToRemove)
+{
+	FObjectTagRelationshipIndex& RelationshipIndex = FObjectTagRelationshipIndex::Get();
+
+	//Make sure every tracked relationship is indexed before reading the blocked lookup,
+	//relationships restored from a save might not have been used yet.
+	TArray<int32, TInlineAllocator<8>> TrackedIds;
+	for(const TSubclassOf<UO_TagRelationship>& CurrentRelationship : ObjectTag.TagRelationships)
+	{
+		TrackedIds.Add(RelationshipIndex.FindOrAddRelationshipId(CurrentRelationship));
+	}
+
+	TArray<int32, TInlineAllocator<8>> BlockedIds;
+	for(const uint16 TagIndex : NewTagIndices)
+	{
+		for(const int32 BlockedId : RelationshipIndex.GetRelationshipsBlockedBy(TagIndex))
+		{
+			BlockedIds.AddUnique(BlockedId);
+		}
+	}
+
+	if(BlockedIds.IsEmpty())
+	{
+		return;
+	}
+
+	for(int32 CurrentRelationship = TrackedIds.Num() - 1; CurrentRelationship >= 0; CurrentRelationship--)
+	{
+		if(BlockedIds.Contains(TrackedIds[CurrentRelationship]))
+		{
+			const uint16 TagIndex = RelationshipIndex.GetRelationship(TrackedIds[CurrentRelationship]).TagIndex;
+			OutTagsToRemove.AddTag(FObjectTagIndexTable::Get().GetTag(TagIndex));
+			ObjectTag.TagRelationships.RemoveAt(CurrentRelationship);
+		}
+	}
+}
+
 bool UObjectTags_Subsystem::HasRequiredTags(TSubclassOf<UO_TagRelationship> Relationship,
 	FGameplayTagContainer Container)
 {
 	return Container.HasAllExact(Relationship.GetDefaultObject()->RequiredTags);
 }
 
+void UObjectTags_Subsystem::MemoryReportConsoleCommand()
+{
+	UObjectTags_Subsystem* Tags_Subsystem = UObjectTags_Subsystem::Get();
+	if(!Tags_Subsystem)
+	{
+		return;
+	}
+
+	const int32 ObjectCount = Tags_Subsystem->ObjectTags.Num();
+	int32 TagCount = 0;
+	SIZE_T CompactBytes = 0;
+	SIZE_T MapBytes = 0;
+	SIZE_T EntryBytes = 0;
+	for(const auto& CurrentObject : Tags_Subsystem->ObjectTags)
+	{
+		TagCount += CurrentObject.Value.NumTags();
+		CompactBytes += sizeof(CurrentObject.Value.TagIndices) + sizeof(CurrentObject.Value.TagValues) + CurrentObject.Value.GetTagStorageAllocatedSize();
+
+		//Everything the entry costs, not just the tags.
+		EntryBytes += sizeof(FObjectTagEntry) + CurrentObject.Value.GetTagStorageAllocatedSize() + CurrentObject.Value.GetExtraAllocatedSize();
+		
+		//Build the map the old storage would have used, purely to measure it.
+		const TMap<FGameplayTag, float> TagsAndValues = CurrentObject.Value.GetTagsAndValues();
+		MapBytes += sizeof(TagsAndValues) + TagsAndValues.GetAllocatedSize();
+	}
+
+	const float Divider = FMath::Max(ObjectCount, 1);
+	UE_LOG(ObjectTagsLog, Display, TEXT("ObjectTags memory: %d objects, %d tags (%.2f per object)"), ObjectCount, TagCount, TagCount / Divider);
+	UE_LOG(ObjectTagsLog, Display, TEXT("  Compact storage: %llu bytes total, %.1f bytes per object"), (uint64)CompactBytes, CompactBytes / Divider);
+	UE_LOG(ObjectTagsLog, Display, TEXT("  TMap storage:    %llu bytes total, %.1f bytes per object"), (uint64)MapBytes, MapBytes / Divider);
+	UE_LOG(ObjectTagsLog, Display, TEXT("  Entry size:      %d bytes per object, before any of the above"), (int32)sizeof(FObjectTagEntry));
+	UE_LOG(ObjectTagsLog, Display, TEXT("  Entry total:     %llu bytes total, %.1f bytes per object, with the entry, tags, cached container and subscriptions"),
+		(uint64)EntryBytes, EntryBytes / Divider);
+	UE_LOG(ObjectTagsLog, Display, TEXT("  Interned tags:   %d"), FObjectTagIndexTable::Get().Num());
+}
+
 AActor* UObjectTags_Subsystem::GetActorForConsoleCommand()
 {
 	UObjectTags_Subsystem* Tags_Subsystem = UObjectTags_Subsystem::Get();
@@ -0,0 +1,62 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+
+#include "ObjectTags_TagIndex.h"
+
+#include "GameplayTagsManager.h"
+
+FObjectTagIndexTable& FObjectTagIndexTable::Get()
+{
+	static FObjectTagIndexTable Table;
+	return Table;
+}
+
+void FObjectTagIndexTable::Initialize()
+{
+	FGameplayTagContainer AllTags;
+	UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, false);
+
+	TagToIndex.Reserve(AllTags.Num());
+	IndexToTag.Reserve(AllTags.Num());
+	ParentIndices.Reserve(AllTags.Num());
+	for(const FGameplayTag& CurrentTag : AllTags)
+	{
+		FindOrAddIndex(CurrentTag);
+	}
+}
+
+uint16 FObjectTagIndexTable::FindOrAddIndex(const FGameplayTag& Tag)
+{
+	if(!Tag.IsValid())
+	{
+		return InvalidIndex;
+	}
+
+	if(const uint16* FoundIndex = TagToIndex.Find(Tag))
+	{
+		return *FoundIndex;
+	}
+
+	//Intern the parent first, this lets hierarchy queries walk up the chain by index.
+	const uint16 ParentIndex = FindOrAddIndex(Tag.RequestDirectParent());
+
+	if(!ensureMsgf(IndexToTag.Num() < InvalidIndex, TEXT("ObjectTags ran out of tag indices")))
+	{
+		return InvalidIndex;
+	}
+
+	const uint16 NewIndex = IndexToTag.Add(Tag);
+	ParentIndices.Add(ParentIndex);
+	TagToIndex.Add(Tag, NewIndex);
+	return NewIndex;
+}
+
+uint16 FObjectTagIndexTable::FindIndex(const FGameplayTag& Tag) const
+{
+	if(const uint16* FoundIndex = TagToIndex.Find(Tag))
+	{
+		return *FoundIndex;
+	}
+
+	return InvalidIndex;
+}
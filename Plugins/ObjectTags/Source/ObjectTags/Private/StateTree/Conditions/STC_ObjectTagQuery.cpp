@@ -14,6 +14,7 @@ bool USTC_ObjectTagQuery::TestCondition(FStateTreeExecutionContext& Context) con
 		return false;
 	}
 
-	FObjectTag ObjectTag = UObjectTags_Subsystem::GetObjectTags(Object);
-	return TagQuery.Matches(ObjectTag.GetTagsAsContainer());
+	//Read-only view, this runs every tick so we don't want to copy the whole entry.
+	const FObjectTagEntry* ObjectTag = UObjectTags_Subsystem::FindObjectTags(Object);
+	return TagQuery.Matches(ObjectTag ? ObjectTag->GetCachedTagsContainer() : FGameplayTagContainer::EmptyContainer);
 }
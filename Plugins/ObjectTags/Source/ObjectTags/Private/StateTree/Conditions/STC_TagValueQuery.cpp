@@ -6,60 +6,119 @@
 #include "ObjectTags_Subsystem.h"
 #include "Kismet/KismetSystemLibrary.h"
 
-bool USTC_TagValueQuery::TestCondition(FStateTreeExecutionContext& Context) const
+void FCompiledTagValueQuery::Compile(const TArray<FTagValueQueryEntry>& Entries, bool AllMustMatch)
 {
-	if(TagValueQuery.IsEmpty())
+	FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+	
+	Instructions.Reset(Entries.Num());
+	for(const FTagValueQueryEntry& CurrentEntry : Entries)
 	{
-		UKismetSystemLibrary::PrintString(this, "ObjectTagQuery condition had no object or no tag query");
-		return false;
+		FInstruction& Instruction = Instructions.AddDefaulted_GetRef();
+		//Invalid tags get InvalidIndex, which no object can have, so they never pass.
+		Instruction.TagIndex = IndexTable.FindOrAddIndex(CurrentEntry.Tag);
+		Instruction.Comparison = CurrentEntry.Comparison;
+		Instruction.Operand = CurrentEntry.Value;
+	}
+
+	//Same order as FObjectTagEntry::TagIndices, so evaluation can walk both at once.
+	Instructions.StableSort([](const FInstruction& A, const FInstruction& B)
+	{
+		return A.TagIndex < B.TagIndex;
+	});
+	
+	bAllMustMatch = AllMustMatch;
+	bCompiled = true;
+	SourceHash = HashSource(Entries, AllMustMatch);
+}
+
+void FCompiledTagValueQuery::CompileIfChanged(const TArray<FTagValueQueryEntry>& Entries, bool AllMustMatch)
+{
+	if(!bCompiled || SourceHash != HashSource(Entries, AllMustMatch))
+	{
+		Compile(Entries, AllMustMatch);
 	}
+}
 
-	FObjectTag ObjectTag = UObjectTags_Subsystem::GetObjectTags(Object);
+uint32 FCompiledTagValueQuery::HashSource(const TArray<FTagValueQueryEntry>& Entries, bool AllMustMatch)
+{
+	uint32 Hash = GetTypeHash(AllMustMatch);
+	for(const FTagValueQueryEntry& CurrentEntry : Entries)
+	{
+		Hash = HashCombineFast(Hash, GetTypeHash(CurrentEntry.Tag));
+		Hash = HashCombineFast(Hash, GetTypeHash(CurrentEntry.Value));
+		Hash = HashCombineFast(Hash, GetTypeHash(CurrentEntry.Comparison.GetValue()));
+	}
+	return Hash;
+}
 
-	int32 MatchedQueries = 0;
-	for(auto& CurrentEntry : TagValueQuery)
+bool FCompiledTagValueQuery::Evaluate(const FObjectTagEntry& ObjectTag) const
+{
+	const TArray<uint16>& TagIndices = ObjectTag.TagIndices;
+	int32 TagSlot = 0;
+	
+	for(const FInstruction& Instruction : Instructions)
 	{
-		if(!AllMustMatch && MatchedQueries > 1)
+		while(TagSlot < TagIndices.Num() && TagIndices[TagSlot] < Instruction.TagIndex)
 		{
-			return true;
+			TagSlot++;
 		}
-		
-		float* Value = ObjectTag.TagsAndValues.Find(CurrentEntry.Tag);
-		if(Value)
+
+		bool bPassed = false;
+		if(TagSlot < TagIndices.Num() && TagIndices[TagSlot] == Instruction.TagIndex)
 		{
-			switch (CurrentEntry.Comparison)
+			const float Value = ObjectTag.TagValues[TagSlot];
+			switch(Instruction.Comparison)
 			{
 			case Equals:
-				{
-					if(*Value == CurrentEntry.Value)
-					{
-						MatchedQueries++;
-					}
-					break;
-				}
+				bPassed = Value == Instruction.Operand;
+				break;
 			case LessThan:
-				{
-					if(*Value < CurrentEntry.Value)
-					{
-						MatchedQueries++;
-					}
-					break;
-				}
+				bPassed = Value < Instruction.Operand;
+				break;
 			case GreaterThan:
-				{
-					if(*Value > CurrentEntry.Value)
-					{
-						MatchedQueries++;
-					}
-					break;
-				}
+				bPassed = Value > Instruction.Operand;
+				break;
 			default:
-				{
-					break;
-				}
+				break;
 			}
 		}
+
+		if(bPassed != bAllMustMatch)
+		{
+			//Either something failed when everything had to pass,
+			//or something passed when only one had to.
+			return bPassed;
+		}
+	}
+
+	return bAllMustMatch;
+}
+
+bool USTC_TagValueQuery::TestCondition(FStateTreeExecutionContext& Context) const
+{
+	if(TagValueQuery.IsEmpty())
+	{
+		UKismetSystemLibrary::PrintString(this, "ObjectTagQuery condition had no object or no tag query");
+		return false;
+	}
+
+	const FObjectTagEntry* ObjectTag = UObjectTags_Subsystem::FindObjectTags(Object);
+	if(!ObjectTag)
+	{
+		//Untracked object, none of the entries can match.
+		return false;
 	}
 
-	return AllMustMatch ? MatchedQueries == TagValueQuery.Num() : MatchedQueries > 0;
+	CompiledQuery.CompileIfChanged(TagValueQuery, AllMustMatch);
+
+	return CompiledQuery.Evaluate(*ObjectTag);
+}
+
+#if WITH_EDITOR
+void USTC_TagValueQuery::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	CompiledQuery.bCompiled = false;
 }
+#endif
@@ -15,7 +15,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_SixParams(FListenForTagUpdate, FGameplayTag,
  * 
  */
 UCLASS()
-class OBJECTTAGS_API UAsync_ListenForTagUpdate : public UCancellableAsyncAction, public II_ObjectTagsCommunication
+class OBJECTTAGS_API UAsync_ListenForTagUpdate : public UCancellableAsyncAction
 {
 	GENERATED_BODY()
 
@@ -32,5 +32,8 @@ class OBJECTTAGS_API UAsync_ListenForTagUpdate : public UCancellableAsyncAction,
 	UPROPERTY(BlueprintAssignable)
 	FListenForTagUpdate OnTagUpdate;
 
-	virtual void ListeningObjectTagsUpdated_Implementation(FGameplayTag Tag, ETagModification Modification, UObject* Object, UObject* Modifier, float NewValue, float Duration) override;
+	/**Subscribed to the tag only, so we're never called for other tags.*/
+	FDelegateHandle SubscriptionHandle;
+
+	void OnTrackedTagChanged(FGameplayTag Tag, ETagModification Modification, UObject* Object, UObject* Modifier, float NewValue, float Duration);
 };
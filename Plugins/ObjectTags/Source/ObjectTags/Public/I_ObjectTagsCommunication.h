@@ -15,6 +15,33 @@ enum ETagModification
 	ValueModified
 };
 
+/**Every change a bulk operation made to a single object.
+ * Sent once per object instead of once per tag.*/
+USTRUCT(BlueprintType)
+struct FObjectTagsDelta
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Category = "ObjectTags", BlueprintReadOnly)
+	FGameplayTagContainer AddedTags;
+
+	UPROPERTY(Category = "ObjectTags", BlueprintReadOnly)
+	FGameplayTagContainer RemovedTags;
+
+	/**Value the @AddedTags were given.*/
+	UPROPERTY(Category = "ObjectTags", BlueprintReadOnly)
+	float Value = 1;
+
+	/**Duration the @AddedTags were given.*/
+	UPROPERTY(Category = "ObjectTags", BlueprintReadOnly)
+	float Duration = 0;
+
+	bool IsEmpty() const
+	{
+		return AddedTags.IsEmpty() && RemovedTags.IsEmpty();
+	}
+};
+
 // This class does not need to be modified.
 UINTERFACE()
 class UI_ObjectTagsCommunication : public UInterface
@@ -50,4 +77,15 @@ public:
 	 * tag updates, and @OwningTagsUpdated has been called on that object.*/
 	UFUNCTION(Category = "ObjectTags", BlueprintNativeEvent, BlueprintCallable)
 	void ListeningObjectTagsUpdated(FGameplayTag Tag, ETagModification Modification, UObject* Object, UObject* Modifier, float NewValue, float Duration);
+
+	/**The one who receives this function call has had several tags updated
+	 * at once through AddTagsToObjects or RemoveTagsFromObjects.
+	 * By default this calls @OwningTagsUpdated for every tag in the @Delta.*/
+	UFUNCTION(Category = "ObjectTags", BlueprintNativeEvent, BlueprintCallable)
+	void OwningTagsBatchUpdated(const FObjectTagsDelta& Delta, UObject* Modifier);
+
+	/**Bulk version of @ListeningObjectTagsUpdated.
+	 * By default this calls @ListeningObjectTagsUpdated for every tag in the @Delta.*/
+	UFUNCTION(Category = "ObjectTags", BlueprintNativeEvent, BlueprintCallable)
+	void ListeningObjectTagsBatchUpdated(const FObjectTagsDelta& Delta, UObject* Object, UObject* Modifier);
 };
@@ -46,4 +46,8 @@ public:
 	 * from the object.*/
 	UPROPERTY(Category = "Tag Mapping", BlueprintReadOnly, EditAnywhere)
 	FGameplayTagContainer RemoveTags;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 };
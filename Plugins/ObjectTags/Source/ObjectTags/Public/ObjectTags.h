@@ -4,6 +4,27 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "UObject/ObjectKey.h"
+
+class AActor;
+class UWorld;
+struct FObjectTagEntry;
+
+/**Cached text for one actor in the in-world debugger.*/
+struct FObjectTagDebugLabel
+{
+	FString Text;
+	FVector Offset = FVector::ZeroVector;
+
+	/**FObjectTagEntry::Revision the text was built from.*/
+	uint32 Revision = 0;
+
+	/**GFrameCounter of the last frame the label was drawn, labels that weren't drawn are dropped.*/
+	uint64 DrawnFrame = 0;
+
+	/**Remaining durations change every frame, so labels with timers can't be cached.*/
+	bool bHasTimers = false;
+};
 
 class FObjectTagsModule : public IModuleInterface
 {
@@ -19,6 +40,20 @@ public:
 private:
 	FTSTicker::FDelegateHandle TickDelegateHandle;
 	bool Tick(float DeltaTime);
+
+	void RebuildDebugLabel(FObjectTagDebugLabel& Label, const FObjectTagEntry& ObjectTag, AActor* Actor);
+
+	/**Walk every tracked object and keep the actors within @GatherDistance of the view,
+	 * 0 meaning any distance, as the candidates Tick looks at until the next gather.*/
+	void GatherDebugCandidates(const TMap<TObjectPtr<UObject>, FObjectTagEntry>& AllObjectTags, UWorld* World, const FVector& ViewLocation, float GatherDistance);
+
+	TMap<FObjectKey, FObjectTagDebugLabel> DebugLabels;
+
+	/**Tagged actors close enough to the view to possibly get a label.*/
+	TArray<TWeakObjectPtr<AActor>> DebugCandidates;
+	TWeakObjectPtr<UWorld> DebugCandidatesWorld;
+	FVector DebugCandidatesLocation = FVector::ZeroVector;
+	double NextDebugCandidatesTime = 0;
 	
 	//------------------
 };
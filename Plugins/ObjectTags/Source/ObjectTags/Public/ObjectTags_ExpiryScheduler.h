@@ -0,0 +1,108 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**Hashed timing wheel that expires temporary tags.
+ * Every temporary tag gets a small entry instead of its own timer and lambda.
+ * Scheduling, refreshing and cancelling a tag are all O(1), and everything
+ * that expired during a frame is gathered in a single pass by Advance.*/
+class OBJECTTAGS_API FObjectTagExpiryScheduler
+{
+public:
+
+	struct FExpiredTag
+	{
+		TWeakObjectPtr<UObject> Object;
+		TWeakObjectPtr<UObject> Modifier;
+		uint16 TagIndex = 0;
+	};
+
+	/**@SlotCount How many slots the wheel has.
+	 * @SlotDuration How many seconds each slot covers. Tags expire at most
+	 * this late, tags further away than a full rotation simply wait in
+	 * their slot for another lap.*/
+	explicit FObjectTagExpiryScheduler(int32 SlotCount = 512, double SlotDuration = 1.0 / 30.0);
+
+	/**Schedule the tag to expire in @Duration seconds.
+	 * If it is already scheduled, the expiry is refreshed instead.*/
+	void Schedule(UObject* Object, uint16 TagIndex, UObject* Modifier, double Duration);
+
+	/**Stop the tag from expiring, for example because it was removed manually.*/
+	void Cancel(const UObject* Object, uint16 TagIndex);
+
+	/**Stop all the @TagIndices of the @Object from expiring.
+	 * Still works after the object is gone, the weak pointer keeps its index and serial number.*/
+	void CancelObject(const TWeakObjectPtr<UObject>& Object, TConstArrayView<uint16> TagIndices);
+
+	bool IsScheduled(const UObject* Object, uint16 TagIndex) const;
+
+	/**Seconds until the tag expires, or -1 if the tag isn't temporary.*/
+	double GetRemainingTime(const UObject* Object, uint16 TagIndex) const;
+
+	/**Move the clock forward and gather every tag that has expired.*/
+	void Advance(double DeltaTime, TArray<FExpiredTag>& OutExpiredTags);
+
+	/**Forget every scheduled tag.*/
+	void Reset();
+
+	int32 Num() const { return Entries.Num(); }
+
+	double GetTime() const { return CurrentTime; }
+
+private:
+
+	struct FEntry
+	{
+		TWeakObjectPtr<UObject> Object;
+		TWeakObjectPtr<UObject> Modifier;
+		double ExpiryTime = 0;
+
+		/**Changes every time the entry is rescheduled,
+		 * anything in a slot with an older sequence is stale.*/
+		uint32 Sequence = 0;
+		uint16 TagIndex = 0;
+	};
+
+	struct FSlotEntry
+	{
+		int32 EntryId = INDEX_NONE;
+		uint32 Sequence = 0;
+	};
+
+	/**Compares the index and serial number of the weak pointer instead of the object,
+	 * so entries can still be found and removed after the object is gone.*/
+	struct FEntryKey
+	{
+		TWeakObjectPtr<const UObject> Object;
+		uint16 TagIndex = 0;
+
+		FEntryKey(const TWeakObjectPtr<const UObject>& InObject, uint16 InTagIndex)
+			: Object(InObject)
+			, TagIndex(InTagIndex)
+		{
+		}
+
+		bool operator==(const FEntryKey& Argument) const
+		{
+			return TagIndex == Argument.TagIndex && Object.HasSameIndexAndSerialNumber(Argument.Object);
+		}
+
+		friend uint32 GetTypeHash(const FEntryKey& Key)
+		{
+			return HashCombineFast(GetTypeHash(Key.Object), Key.TagIndex);
+		}
+	};
+
+	int32 GetSlotForExpiry(double ExpiryTime) const;
+
+	TSparseArray<FEntry> Entries;
+	TMap<FEntryKey, int32> EntryLookup;
+	TArray<TArray<FSlotEntry>> Slots;
+
+	double SlotDuration = 0;
+	double CurrentTime = 0;
+	int64 LastProcessedTick = 0;
+	uint32 NextSequence = 1;
+};
@@ -0,0 +1,76 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "I_ObjectTagsCommunication.h"
+#include "UObject/ObjectKey.h"
+#include <atomic>
+
+/**Tag history is compiled into every build except shipping,
+ * so Test builds can still be used for tag forensics.*/
+#ifndef OBJECTTAGS_WITH_HISTORY
+#define OBJECTTAGS_WITH_HISTORY !UE_BUILD_SHIPPING
+#endif
+
+#if OBJECTTAGS_WITH_HISTORY
+
+/**A single tag change. Kept small and allocation free,
+ * names are only resolved when the history is read.*/
+struct FObjectTagHistoryRecord
+{
+	FObjectKey Object;
+	FObjectKey Modifier;
+	double Time = 0;
+	uint16 TagIndex = 0;
+	TEnumAsByte<ETagModification> Modification = Added;
+};
+
+/**Fixed size history of every tag change across all objects.
+ * Writers claim a slot with a single atomic increment, so recording never
+ * locks or allocates. Once full, the oldest records are overwritten.
+ * Every slot carries a sequence number, readers skip records that are
+ * being overwritten while they read them.*/
+class OBJECTTAGS_API FObjectTagHistoryBuffer
+{
+public:
+
+	static FObjectTagHistoryBuffer& Get();
+
+	/**@Capacity is rounded up to a power of two.*/
+	explicit FObjectTagHistoryBuffer(uint32 Capacity = 16384);
+
+	void Record(const UObject* Object, uint16 TagIndex, ETagModification Modification, const UObject* Modifier);
+
+	/**Copy every record still in the buffer, oldest first.
+	 * If @Object is set, only records for that object are copied.*/
+	void GetRecords(TArray<FObjectTagHistoryRecord>& OutRecords, const UObject* Object = nullptr) const;
+
+	/**Total amount of records ever written, including overwritten ones.*/
+	uint64 GetTotalRecorded() const { return Head.load(); }
+
+	uint32 GetCapacity() const { return SlotCount; }
+
+	/**Turn records into readable lines, used by ObjectTags.DumpHistory.*/
+	static FString RecordToString(const FObjectTagHistoryRecord& Record);
+
+	/**ObjectTags.DumpHistory [FileName]
+	 * Log the history, or write it to Saved/ObjectTags/FileName.*/
+	static void DumpHistoryConsoleCommand(const TArray<FString>& Args);
+
+private:
+
+	struct FSlot
+	{
+		/**0 while being written, otherwise the ticket of the record + 1.*/
+		std::atomic<uint64> Sequence = 0;
+		FObjectTagHistoryRecord Record;
+	};
+
+	TUniquePtr<FSlot[]> Slots;
+	uint32 SlotCount = 0;
+	uint64 Mask = 0;
+	std::atomic<uint64> Head = 0;
+};
+
+#endif
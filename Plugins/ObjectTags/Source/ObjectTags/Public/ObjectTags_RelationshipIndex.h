@@ -0,0 +1,80 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ObjectTags_TagIndex.h"
+#include "UObject/ObjectKey.h"
+
+class UO_TagRelationship;
+
+/**A UO_TagRelationship CDO flattened into interned tag indices.
+ * Every tag array is sorted, same as FObjectTagEntry::TagIndices.*/
+struct FObjectTagRelationshipInfo
+{
+	TWeakObjectPtr<UClass> RelationshipClass;
+
+	uint16 TagIndex = FObjectTagIndexTable::InvalidIndex;
+	float Value = 1;
+
+	TArray<uint16> RequiredTags;
+	TArray<uint16> BlockingTags;
+	TArray<uint16> RemoveTags;
+
+	bool bRemoveTagIfAnyBlockingTagIsApplied = true;
+};
+
+/**Index of every tag relationship, built once instead of reading the
+ * relationship CDOs and their tag containers every time a tag is applied.
+ * Besides the flattened relationships, this keeps which relationships
+ * every tag blocks, so applying a tag doesn't have to check all of them.*/
+class OBJECTTAGS_API FObjectTagRelationshipIndex
+{
+public:
+
+	static FObjectTagRelationshipIndex& Get();
+
+	/**Index every relationship class that is currently loaded.
+	 * Anything loaded later is indexed the first time it's used.*/
+	void Build();
+
+	/**Forget everything, used when relationship classes are edited or reinstanced.*/
+	void Reset();
+
+	/**Get the id of the @RelationshipClass, indexing it if needed.
+	 * Returns INDEX_NONE for invalid classes.
+	 * Ids stay valid until Reset is called.*/
+	int32 FindOrAddRelationshipId(TSubclassOf<UO_TagRelationship> RelationshipClass);
+
+	const FObjectTagRelationshipInfo& GetRelationship(int32 RelationshipId) const
+	{
+		return Relationships[RelationshipId];
+	}
+
+	/**Relationships that the tag at @TagIndex blocks.*/
+	TConstArrayView<int32> GetRelationshipsBlockedBy(uint16 TagIndex) const
+	{
+		return FindRelationships(BlockedBy, TagIndex);
+	}
+
+	int32 Num() const { return Relationships.Num(); }
+
+	/**Are any of the sorted @TagIndices inside the sorted @Other?*/
+	static bool HasAnyTagIndex(TConstArrayView<uint16> TagIndices, TConstArrayView<uint16> Other);
+
+	/**Are all of the sorted @TagIndices inside the sorted @Other?*/
+	static bool HasAllTagIndices(TConstArrayView<uint16> TagIndices, TConstArrayView<uint16> Other);
+
+private:
+
+	static TConstArrayView<int32> FindRelationships(const TMap<uint16, TArray<int32>>& Map, uint16 TagIndex)
+	{
+		const TArray<int32>* Found = Map.Find(TagIndex);
+		return Found ? TConstArrayView<int32>(*Found) : TConstArrayView<int32>();
+	}
+
+	TArray<FObjectTagRelationshipInfo> Relationships;
+	TMap<FObjectKey, int32> ClassToRelationship;
+
+	TMap<uint16, TArray<int32>> BlockedBy;
+};
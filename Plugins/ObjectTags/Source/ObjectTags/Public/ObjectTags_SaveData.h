@@ -0,0 +1,31 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**Versions of the object tags save format.
+ * Add a new entry before VersionPlusOne whenever the format changes,
+ * and keep loading the older versions.
+ *
+ * Layout, all counts and indices are packed ints:
+ * - Magic, Version
+ * - Tag name table, only tags that are in use. Sorted by tag index,
+ *   so each objects tags can be written as small deltas.
+ * - Relationship class path table
+ * - Objects: object path, tag count, delta encoded tag table indices,
+ *   values XOR'd against the previous value (an object full of 1's is a byte per value),
+ *   remaining durations of temporary tags, relationship table indices.*/
+enum class EObjectTagsSaveVersion : uint16
+{
+	Initial = 1,
+
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+namespace ObjectTagsSaveData
+{
+	/**"OTAG", so we can tell garbage apart from an old version.*/
+	static constexpr uint32 Magic = 0x4741544F;
+}
@@ -0,0 +1,91 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "UObject/ObjectKey.h"
+#include <atomic>
+
+struct FObjectTagEntry;
+
+/**Immutable, flattened copy of every objects tags and values.
+ * Only ever written by the game thread while no reader can see it.*/
+struct FObjectTagsSnapshotData
+{
+	struct FObjectRange
+	{
+		int32 Start = 0;
+		int32 Num = 0;
+	};
+
+	TMap<FObjectKey, FObjectRange> Objects;
+
+	/**Every objects tags back to back, @Objects points into these.
+	 * Tags are stored directly instead of as indices, so readers never
+	 * have to touch the game thread owned FObjectTagIndexTable.*/
+	TArray<FGameplayTag> Tags;
+	TArray<float> Values;
+
+	const float* FindValue(const FObjectKey& Object, const FGameplayTag& Tag) const;
+};
+
+/**Lets worker threads query object tags without locks.
+ * The game thread publishes a new snapshot at most once per frame into
+ * one of three buffers. Readers pin the current buffer for the duration
+ * of a single query, and the game thread never writes into a buffer that
+ * is current or pinned, skipping the publish if every buffer is busy.
+ * Every UObjectTags_Subsystem owns one and registers it while it runs.
+ * Objects only belong to one game instance, so the static queries can
+ * look them up in every registered snapshot without mixing instances up.*/
+class OBJECTTAGS_API FObjectTagsSnapshot
+{
+public:
+
+	/**Game thread only. Forget every published buffer, no reader may be using this.*/
+	void Reset();
+
+	/**Game thread only. Make this snapshot visible to FindTagValue_AnyThread.*/
+	void Register();
+
+	/**Game thread only. Hide this snapshot from FindTagValue_AnyThread and
+	 * wait for the queries that are still reading it, after which it can be reset or destroyed.*/
+	void Unregister();
+
+	/**Game thread only. Copy the @ObjectTags into a free buffer
+	 * and make it current. Returns false if every buffer was in use,
+	 * in which case this should be tried again next frame.*/
+	bool Publish(const TMap<TObjectPtr<UObject>, FObjectTagEntry>& ObjectTags, uint32 Revision);
+
+	/**Revision of the state the current snapshot was made from.*/
+	uint32 GetPublishedRevision() const { return PublishedRevision; }
+
+	//Any thread
+
+	bool DoesObjectHaveTag(const UObject* Object, const FGameplayTag& Tag) const;
+
+	/**Returns false if the object doesn't have the tag.*/
+	bool GetTagValue(const UObject* Object, const FGameplayTag& Tag, float& OutValue) const;
+
+	/**Find the @Tag on the @Object in whichever registered snapshot has it.
+	 * Returns false if none of them do.*/
+	static bool FindTagValue_AnyThread(const UObject* Object, const FGameplayTag& Tag, float& OutValue);
+
+private:
+
+	static constexpr int32 BufferCount = 3;
+
+	/**Returns the pinned buffer index, or INDEX_NONE if nothing was published yet.*/
+	int32 PinCurrentBuffer() const;
+
+	void UnpinBuffer(int32 BufferIndex) const
+	{
+		ReaderCounts[BufferIndex].fetch_sub(1);
+	}
+
+	FObjectTagsSnapshotData Buffers[BufferCount];
+	mutable std::atomic<int32> ReaderCounts[BufferCount] = {};
+	std::atomic<int32> CurrentBuffer = INDEX_NONE;
+
+	uint32 PublishedRevision = 0;
+};
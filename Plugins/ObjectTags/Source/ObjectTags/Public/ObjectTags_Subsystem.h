@@ -6,10 +6,18 @@
 #include "GameplayTagContainer.h"
 #include "I_ObjectTagsCommunication.h"
 #include "O_TagRelationship.h"
+#include "ObjectTags_TagIndex.h"
+#include "ObjectTags_ExpiryScheduler.h"
+#include "ObjectTags_Snapshot.h"
+#include "Tickable.h"
+#include "Templates/PimplPtr.h"
+#include "Algo/BinarySearch.h"
 #include "Kismet/KismetSystemLibrary.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "ObjectTags_Subsystem.generated.h"
 
+class UAbilitySystemComponent;
+
 USTRUCT(BlueprintType)
 struct FObjectTagHistory
 {
@@ -25,10 +33,148 @@ struct FObjectTagHistory
 
 	UPROPERTY(BlueprintReadOnly)
 	bool Added = false;
+
+	/**Platform time in seconds the change happened at.*/
+	UPROPERTY(BlueprintReadOnly)
+	double Time = 0;
+};
+
+/**Whether the @Object implements UI_ObjectTagsCommunication.
+ * This walks the class interface list, so callers cache the result
+ * instead of doing this on every broadcast.*/
+inline bool DoesObjectImplementTagsCommunication(const UObject* Object)
+{
+	return Object && Object->GetClass()->ImplementsInterface(UI_ObjectTagsCommunication::StaticClass());
+}
+
+/**Native callback for a single tag changing on an object.*/
+DECLARE_DELEGATE_SixParams(FOnObjectTagChanged, FGameplayTag /*Tag*/, ETagModification /*Modification*/, UObject* /*Object*/,
+	UObject* /*Modifier*/, float /*NewValue*/, float /*Duration*/);
+
+/**A listener that only wants to hear about some of an objects tags.*/
+struct FObjectTagSubscription
+{
+	/**Receives ListeningObjectTagsUpdated, unused for native subscriptions.*/
+	TWeakObjectPtr<UObject> Listener;
+
+	/**Called directly, without going through the interface.*/
+	FOnObjectTagChanged Delegate;
+
+	/**Only used by subscriptions made with SubscribeToTagQuery.*/
+	FGameplayTagQuery TagQuery;
+
+	FDelegateHandle Handle;
+
+	/**If false, changes to any child of the subscribed tag are delivered too.*/
+	bool bExactMatch = true;
+
+	/**Cached when subscribing, see DoesObjectImplementTagsCommunication.*/
+	bool bImplementsInterface = false;
+
+	/**Set when unsubscribed while subscribers are being notified,
+	 * see UObjectTags_Subsystem::RemoveSubscriptions.*/
+	bool bRemoved = false;
+
+	void Notify(FGameplayTag Tag, ETagModification Modification, UObject* Object, UObject* Modifier, float Value, float Duration) const
+	{
+		if(Delegate.IsBound())
+		{
+			Delegate.Execute(Tag, Modification, Object, Modifier, Value, Duration);
+		}
+		else if(bImplementsInterface)
+		{
+			if(UObject* ListenerObject = Listener.Get())
+			{
+				II_ObjectTagsCommunication::Execute_ListeningObjectTagsUpdated(ListenerObject, Tag, Modification, Object, Modifier, Value, Duration);
+			}
+		}
+	}
+};
+
+/**Where to find a subscription that was gathered for a broadcast.
+ * The subscription itself is looked up again right before it's notified.*/
+struct FObjectTagSubscriptionRef
+{
+	FDelegateHandle Handle;
+
+	/**The tag the subscription is told about.*/
+	FGameplayTag Tag;
+
+	/**Key in FObjectTagSubscriptions::TagSubscriptions, InvalidIndex for QuerySubscriptions.*/
+	uint16 TagIndex = FObjectTagIndexTable::InvalidIndex;
+
+	/**Position in that array when it was gathered, checked before searching it.*/
+	int32 Position = INDEX_NONE;
+};
+
+typedef TArray<FObjectTagSubscriptionRef, TInlineAllocator<8>> FObjectTagSubscriptionArray;
+
+/**Every subscription made to a single object. Most objects never get one,
+ * so entries only allocate this on the first subscribe.*/
+struct FObjectTagSubscriptions
+{
+	/**Listeners that only care about a single tag (and optionally its children),
+	 * keyed by the interned tag index. Only these are called for changes to that tag.*/
+	TMap<uint16, TArray<FObjectTagSubscription>> TagSubscriptions;
+
+	/**Listeners filtered by a tag query, tested against every changed tag.*/
+	TArray<FObjectTagSubscription> QuerySubscriptions;
+
+	bool IsEmpty() const
+	{
+		return TagSubscriptions.IsEmpty() && QuerySubscriptions.IsEmpty();
+	}
+
+	/**Memory used by these subscriptions, including this struct.*/
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T Size = sizeof(*this) + TagSubscriptions.GetAllocatedSize() + QuerySubscriptions.GetAllocatedSize();
+		for(const TPair<uint16, TArray<FObjectTagSubscription>>& CurrentSubscriptions : TagSubscriptions)
+		{
+			Size += CurrentSubscriptions.Value.GetAllocatedSize();
+		}
+		return Size;
+	}
 };
 
 USTRUCT(BlueprintType)
-struct FObjectTag
+struct FObjectTagListener
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Category = "Object Tags", BlueprintReadOnly)
+	TObjectPtr<UObject> Listener = nullptr;
+
+	/**Cached when the listener is added, so broadcasting doesn't
+	 * have to check the class interfaces for every tag change.
+	 * Refreshed when blueprints are reinstanced.*/
+	bool bImplementsInterface = false;
+
+	FObjectTagListener() = default;
+
+	explicit FObjectTagListener(UObject* InListener)
+		: Listener(InListener)
+		, bImplementsInterface(DoesObjectImplementTagsCommunication(InListener))
+	{
+	}
+
+	bool operator==(const FObjectTagListener& Argument) const
+	{
+		return Argument.Listener == Listener;
+	}
+
+	bool operator==(const UObject* Argument) const
+	{
+		return Argument == Listener;
+	}
+};
+
+struct FObjectTag;
+
+/**Everything the subsystem stores for a single object.
+ * Blueprints get a FObjectTag through UObjectTags_Subsystem::GetObjectTags instead.*/
+USTRUCT()
+struct FObjectTagEntry
 {
 	GENERATED_BODY()
 
@@ -38,96 +184,507 @@ struct FObjectTag
 	UPROPERTY(Category = "Object Tags", BlueprintReadOnly)
 	TObjectPtr<UObject> Object = nullptr;
 
-	/**What tags have been added with this system?
-	 * Keep in mind, you should always use GetObjectTags,
-	 * as that will also fetch any external tags.*/
-	UPROPERTY(Category = "Object Tags", BlueprintReadOnly)
-	TMap<FGameplayTag, float> TagsAndValues;
+	/**Same object as @Object, set together with it by SetObject. The garbage collector
+	 * nulls @Object, but this keeps its index and serial number, so it still finds
+	 * the objects entries in the reverse index after the object is gone.*/
+	TWeakObjectPtr<UObject> WeakObject;
 
-	UPROPERTY(Category = "Object Tags", BlueprintReadOnly)
-	TArray<TObjectPtr<UObject>> Listeners;
+	/**What tags have been added with this system, stored as interned
+	 * indices (see FObjectTagIndexTable) and kept sorted so lookups are
+	 * a binary search. Blueprints should use GetObjectTagsAndValues.
+	 * Use ObjectTags.MemoryReport to see what this costs compared to a map.*/
+	TArray<uint16> TagIndices;
+
+	/**Value of each tag, parallel to @TagIndices.*/
+	TArray<float> TagValues;
+
+	/**Container version of @TagIndices, only built when someone asks for it
+	 * through GetCachedTagsContainer and rebuilt after the tags change.*/
+	mutable FGameplayTagContainer CachedTagsContainer;
+	mutable bool bCachedTagsContainerDirty = true;
+
+	/**Ability system of the object, resolved the first time its tags are synced to it.
+	 * While it's null it is looked up again, see CatchUpLooseTags.*/
+	TWeakObjectPtr<UAbilitySystemComponent> CachedAbilitySystemComponent;
+
+	/**Frame we last looked for an ability system, so objects without
+	 * one aren't searched again for every tag in the same frame.*/
+	uint64 AbilitySystemResolveFrame = MAX_uint64;
+
+	/**StateRevision of the owning subsystem when the tags or values of this object
+	 * last changed. Never repeats, not even for an entry that is removed and added again.*/
+	uint32 Revision = 0;
+
+	/**Set when the object was destroyed while the entry might still be in use,
+	 * for example by a tag change that is broadcasting. The entry is removed
+	 * at the start of the next tick instead of straight away.*/
+	bool bPendingRemoval = false;
+
+	/**UObjectTags_Subsystem::StateRevision of the subsystem that owns this entry,
+	 * set by SetObject. Bumped by MarkModified.*/
+	uint32* OwnerStateRevision = nullptr;
+
+	/**Listeners that are told about every tag change on this object.*/
+	UPROPERTY()
+	TArray<FObjectTagListener> ListenerEntries;
+
+	/**Cached result of DoesObjectImplementTagsCommunication for @Object,
+	 * resolved on the first broadcast since the owner is assigned in a lot of places.*/
+	mutable bool bObjectInterfaceCached = false;
+	mutable bool bObjectImplementsInterface = false;
+
+	/**Null until something subscribes to this object, see GetOrAddSubscriptions.*/
+	TPimplPtr<FObjectTagSubscriptions, EPimplPtrMode::DeepCopy> Subscribers;
 
 	/**Current tag relationships we are tracking. This is only populated
 	 * by relationships that are tracking if any blocking tags are applied.*/
-	UPROPERTY(Category = "Object Tags", BlueprintReadOnly, SaveGame)
-	TArray<TSubclassOf<UO_TagRelationship>> TagRelationships;
-	
-	/**History of all tags for this object.
-	 * Debugging only, do not use for gameplay.*/
-	UPROPERTY(Category = "DEVELOPMENT", VisibleAnywhere, BlueprintReadOnly)
-	TArray<FObjectTagHistory> TagHistory;
-	//TODO: Remove for cooked builds
-
-	/**Timers for current temporary tags.
-	 * This map is required to allow for tag durations
-	 * to be refreshed.*/
 	UPROPERTY(Category = "Object Tags", BlueprintReadOnly)
-	TMap<FGameplayTag, FTimerHandle> TagTimers;
+	TArray<TSubclassOf<UO_TagRelationship>> TagRelationships;
 
-	bool operator==(const FObjectTag& Argument) const
+	bool operator==(const FObjectTagEntry& Argument) const
 	{
 		return Argument.Object == Object;
 	}
 
+	/**Set @Object and @WeakObject, and the subsystem revision MarkModified bumps.*/
+	void SetObject(UObject* InObject, uint32& InOwnerStateRevision)
+	{
+		Object = InObject;
+		WeakObject = InObject;
+		OwnerStateRevision = &InOwnerStateRevision;
+	}
+
+	/**Copy of this entry with the blueprint only properties filled in.*/
+	FObjectTag MakeBlueprintCopy() const;
+
+	FObjectTagSubscriptions& GetOrAddSubscriptions()
+	{
+		if(!Subscribers.IsValid())
+		{
+			Subscribers = MakePimpl<FObjectTagSubscriptions, EPimplPtrMode::DeepCopy>();
+		}
+		return *Subscribers;
+	}
+
+	/**Free @Subscribers once the last one has been removed.*/
+	void ReleaseEmptySubscriptions()
+	{
+		if(Subscribers.IsValid() && Subscribers->IsEmpty())
+		{
+			Subscribers.Reset();
+		}
+	}
+
+	/**Position of the @TagIndex inside @TagIndices, or INDEX_NONE.*/
+	int32 FindTagSlot(uint16 TagIndex) const
+	{
+		return Algo::BinarySearch(TagIndices, TagIndex);
+	}
+
+	bool HasTag(FGameplayTag Tag) const
+	{
+		return FindTagSlot(FObjectTagIndexTable::Get().FindIndex(Tag)) != INDEX_NONE;
+	}
+
+	const float* FindValue(FGameplayTag Tag) const
+	{
+		const int32 Slot = FindTagSlot(FObjectTagIndexTable::Get().FindIndex(Tag));
+		return Slot != INDEX_NONE ? &TagValues[Slot] : nullptr;
+	}
+
+	int32 NumTags() const { return TagIndices.Num(); }
+
+	bool HasAnyTags() const { return !TagIndices.IsEmpty(); }
+
+	void MarkModified()
+	{
+		Revision = OwnerStateRevision ? ++(*OwnerStateRevision) : Revision + 1;
+	}
+
+	/**Add the @Tag or update its value if we already have it.
+	 * Returns true if the tag was newly added.*/
+	bool SetTag(FGameplayTag Tag, float Value)
+	{
+		const uint16 TagIndex = FObjectTagIndexTable::Get().FindOrAddIndex(Tag);
+		if(TagIndex == FObjectTagIndexTable::InvalidIndex)
+		{
+			return false;
+		}
+
+		const int32 Slot = Algo::LowerBound(TagIndices, TagIndex);
+		if(TagIndices.IsValidIndex(Slot) && TagIndices[Slot] == TagIndex)
+		{
+			TagValues[Slot] = Value;
+			MarkModified();
+			return false;
+		}
+
+		TagIndices.Insert(TagIndex, Slot);
+		TagValues.Insert(Value, Slot);
+		bCachedTagsContainerDirty = true;
+		MarkModified();
+		return true;
+	}
+
+	/**Returns true if the tag was found and removed.*/
+	bool RemoveTag(FGameplayTag Tag)
+	{
+		const int32 Slot = FindTagSlot(FObjectTagIndexTable::Get().FindIndex(Tag));
+		if(Slot == INDEX_NONE)
+		{
+			return false;
+		}
+
+		TagIndices.RemoveAt(Slot);
+		TagValues.RemoveAt(Slot);
+		bCachedTagsContainerDirty = true;
+		MarkModified();
+		return true;
+	}
+
 	void SetValueForTag(FGameplayTag Tag, float NewValue)
 	{
-		if(float* FoundTagValue = TagsAndValues.Find(Tag))
+		const int32 Slot = FindTagSlot(FObjectTagIndexTable::Get().FindIndex(Tag));
+		if(Slot != INDEX_NONE)
 		{
-			*FoundTagValue = NewValue;
+			TagValues[Slot] = NewValue;
+			MarkModified();
 		}
 	}
 
-	FGameplayTagContainer GetTagsAsContainer()
+	FGameplayTagContainer GetTagsAsContainer() const
 	{
+		const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
 		FGameplayTagContainer TagContainer;
-		for(auto& CurrentTag : TagsAndValues)
+		for(const uint16 CurrentIndex : TagIndices)
 		{
-			TagContainer.AddTagFast(CurrentTag.Key);
+			TagContainer.AddTagFast(IndexTable.GetTag(CurrentIndex));
 		}
 		return TagContainer;
 	}
 
+	/**Same as GetTagsAsContainer, but the container is cached on this object
+	 * and reused until the tags change, so repeated queries don't allocate.*/
+	const FGameplayTagContainer& GetCachedTagsContainer() const
+	{
+		if(bCachedTagsContainerDirty)
+		{
+			const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+			CachedTagsContainer.Reset(TagIndices.Num());
+			for(const uint16 CurrentIndex : TagIndices)
+			{
+				//TagIndices never holds duplicates, so the uniqueness check of AddTag isn't needed.
+				CachedTagsContainer.AddTagFast(IndexTable.GetTag(CurrentIndex));
+			}
+			bCachedTagsContainerDirty = false;
+		}
+		return CachedTagsContainer;
+	}
+
+	TMap<FGameplayTag, float> GetTagsAndValues() const
+	{
+		const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+		TMap<FGameplayTag, float> FoundTags;
+		FoundTags.Reserve(TagIndices.Num());
+		for(int32 CurrentSlot = 0; CurrentSlot < TagIndices.Num(); CurrentSlot++)
+		{
+			FoundTags.Add(IndexTable.GetTag(TagIndices[CurrentSlot]), TagValues[CurrentSlot]);
+		}
+		return FoundTags;
+	}
+
+	/**Heap memory used by the tag storage of this object.*/
+	SIZE_T GetTagStorageAllocatedSize() const
+	{
+		return TagIndices.GetAllocatedSize() + TagValues.GetAllocatedSize();
+	}
+
+	/**Heap memory used by everything else this entry holds on to,
+	 * the cached container, listeners and subscriptions.*/
+	SIZE_T GetExtraAllocatedSize() const
+	{
+		return CachedTagsContainer.GetGameplayTagArray().GetAllocatedSize()
+			+ CachedTagsContainer.GetGameplayTagParents().GetAllocatedSize()
+			+ ListenerEntries.GetAllocatedSize()
+			+ TagRelationships.GetAllocatedSize()
+			+ (Subscribers.IsValid() ? Subscribers->GetAllocatedSize() : 0);
+	}
+
+	bool DoesObjectImplementInterface() const
+	{
+		if(!bObjectInterfaceCached)
+		{
+			bObjectImplementsInterface = DoesObjectImplementTagsCommunication(Object);
+			bObjectInterfaceCached = true;
+		}
+		return bObjectImplementsInterface;
+	}
+
+	/**Forget every cached interface check, used when classes get reinstanced.*/
+	void RefreshInterfaceCache()
+	{
+		bObjectInterfaceCached = false;
+		for(FObjectTagListener& CurrentListener : ListenerEntries)
+		{
+			CurrentListener.bImplementsInterface = DoesObjectImplementTagsCommunication(CurrentListener.Listener);
+		}
+		auto RefreshSubscriptions = [](TArray<FObjectTagSubscription>& Subscriptions)
+		{
+			for(FObjectTagSubscription& CurrentSubscription : Subscriptions)
+			{
+				CurrentSubscription.bImplementsInterface = DoesObjectImplementTagsCommunication(CurrentSubscription.Listener.Get());
+			}
+		};
+		if(Subscribers.IsValid())
+		{
+			for(TPair<uint16, TArray<FObjectTagSubscription>>& CurrentSubscriptions : Subscribers->TagSubscriptions)
+			{
+				RefreshSubscriptions(CurrentSubscriptions.Value);
+			}
+			RefreshSubscriptions(Subscribers->QuerySubscriptions);
+		}
+	}
+
+	bool HasAnyListeners() const
+	{
+		return !ListenerEntries.IsEmpty() || (Subscribers.IsValid() && !Subscribers->IsEmpty());
+	}
+
+	/**Gather every subscription that is interested in the @Tag.
+	 * Gathered up front, so subscriptions made while notifying don't hear about
+	 * this change. Only references are gathered, see NotifySubscriptions.*/
+	void GatherSubscriptions(FGameplayTag Tag, FObjectTagSubscriptionArray& OutSubscriptions) const
+	{
+		if(!Subscribers.IsValid())
+		{
+			return;
+		}
+
+		const TMap<uint16, TArray<FObjectTagSubscription>>& TagSubscriptions = Subscribers->TagSubscriptions;
+		const TArray<FObjectTagSubscription>& QuerySubscriptions = Subscribers->QuerySubscriptions;
+		if(!TagSubscriptions.IsEmpty())
+		{
+			//Walk up the hierarchy, subscriptions on a parent that aren't exact want this change too.
+			const FObjectTagIndexTable& IndexTable = FObjectTagIndexTable::Get();
+			const uint16 TagIndex = IndexTable.FindIndex(Tag);
+			for(uint16 CurrentIndex = TagIndex; CurrentIndex != FObjectTagIndexTable::InvalidIndex; CurrentIndex = IndexTable.GetParentIndex(CurrentIndex))
+			{
+				if(const TArray<FObjectTagSubscription>* Subscriptions = TagSubscriptions.Find(CurrentIndex))
+				{
+					for(int32 CurrentSubscription = 0; CurrentSubscription < Subscriptions->Num(); CurrentSubscription++)
+					{
+						const FObjectTagSubscription& Subscription = (*Subscriptions)[CurrentSubscription];
+						if(!Subscription.bRemoved && (CurrentIndex == TagIndex || !Subscription.bExactMatch))
+						{
+							OutSubscriptions.Add({Subscription.Handle, Tag, CurrentIndex, CurrentSubscription});
+						}
+					}
+				}
+			}
+		}
+
+		if(!QuerySubscriptions.IsEmpty())
+		{
+			const FGameplayTagContainer TagContainer(Tag);
+			for(int32 CurrentSubscription = 0; CurrentSubscription < QuerySubscriptions.Num(); CurrentSubscription++)
+			{
+				const FObjectTagSubscription& Subscription = QuerySubscriptions[CurrentSubscription];
+				if(!Subscription.bRemoved && Subscription.TagQuery.Matches(TagContainer))
+				{
+					OutSubscriptions.Add({Subscription.Handle, Tag, FObjectTagIndexTable::InvalidIndex, CurrentSubscription});
+				}
+			}
+		}
+	}
+
+	/**Find the subscription gathered as @Reference, null if it has been removed since.*/
+	const FObjectTagSubscription* FindSubscription(const FObjectTagSubscriptionRef& Reference) const
+	{
+		if(!Subscribers.IsValid())
+		{
+			return nullptr;
+		}
+
+		const TArray<FObjectTagSubscription>* Subscriptions = Reference.TagIndex == FObjectTagIndexTable::InvalidIndex
+			? &Subscribers->QuerySubscriptions : Subscribers->TagSubscriptions.Find(Reference.TagIndex);
+		if(!Subscriptions)
+		{
+			return nullptr;
+		}
+
+		//Removals are held back while notifying, so it's nearly always still where it was gathered.
+		const FObjectTagSubscription* Subscription = Subscriptions->IsValidIndex(Reference.Position) && (*Subscriptions)[Reference.Position].Handle == Reference.Handle
+			? &(*Subscriptions)[Reference.Position]
+			: Subscriptions->FindByPredicate([&Reference](const FObjectTagSubscription& CurrentSubscription)
+			{
+				return CurrentSubscription.Handle == Reference.Handle;
+			});
+		return Subscription && !Subscription->bRemoved ? Subscription : nullptr;
+	}
+
+	/**Notify every gathered subscription of the @OwningObject. Each one is looked up
+	 * again right before it's called, listeners are allowed to add tags to other
+	 * objects, which can move the entry, or to unsubscribe.*/
+	static void NotifySubscriptions(UObject* OwningObject, const FObjectTagSubscriptionArray& Subscriptions, ETagModification Modification,
+		UObject* Modifier, float Value, float Duration);
+
 	void BroadcastTagChange(FGameplayTag Tag, ETagModification Modification, UObject* Modifier, float Value = 1, float Duration = 0)
 	{
+		FObjectTagSubscriptionArray Subscriptions;
+		GatherSubscriptions(Tag, Subscriptions);
+		
+		//Copied, listeners are allowed to add tags to other objects, which can move this entry.
+		UObject* OwningObject = Object;
+		
 		//Notify the object itself
-		if(UKismetSystemLibrary::DoesImplementInterface(Object, UI_ObjectTagsCommunication::StaticClass()))
+		if(DoesObjectImplementInterface())
 		{
 			II_ObjectTagsCommunication::Execute_OwningTagsUpdated(Object, Tag, Modification, Modifier, Value, Duration);
 		}
 
 		//Notify any listeners
-		for(int32 CurrentListener = 0; CurrentListener < Listeners.Num(); CurrentListener++)
+		for(int32 CurrentListener = 0; CurrentListener < ListenerEntries.Num(); CurrentListener++)
 		{
-			if(!Listeners[CurrentListener])
+			const FObjectTagListener& ListenerEntry = ListenerEntries[CurrentListener];
+			if(!ListenerEntry.Listener || !ListenerEntry.bImplementsInterface)
 			{
 				continue;
 			}
 
-			UObject* Listener = Listeners[CurrentListener];
+			UObject* Listener = ListenerEntry.Listener;
 					
-			if(UKismetSystemLibrary::DoesImplementInterface(Listener, UI_ObjectTagsCommunication::StaticClass()))
-			{
-				II_ObjectTagsCommunication::Execute_ListeningObjectTagsUpdated(Listener, Tag, Modification, Object, Modifier, Value, Duration);
-			}
+			II_ObjectTagsCommunication::Execute_ListeningObjectTagsUpdated(Listener, Tag, Modification, Object, Modifier, Value, Duration);
 
 			//In the case that the listener stops listening, the array changes size.
 			//Adjust it so we don't skip any objects.
-			if(!Listeners.Contains(Listener))
+			if(!ListenerEntries.IsValidIndex(CurrentListener) || ListenerEntries[CurrentListener].Listener != Listener)
 			{
 				CurrentListener--;
 			}
 		}
+
+		//Only subscribers that asked for this tag
+		NotifySubscriptions(OwningObject, Subscriptions, Modification, Modifier, Value, Duration);
+	}
+
+	/**Send a single event with every change in the @Delta to the object and its listeners.*/
+	void BroadcastTagsDelta(const FObjectTagsDelta& Delta, UObject* Modifier)
+	{
+		if(Delta.IsEmpty())
+		{
+			return;
+		}
+
+		//Subscriptions are per tag, so they get a call for each tag they're interested in.
+		FObjectTagSubscriptionArray AddedSubscriptions;
+		FObjectTagSubscriptionArray RemovedSubscriptions;
+		if(Subscribers.IsValid() && !Subscribers->IsEmpty())
+		{
+			for(const FGameplayTag& CurrentTag : Delta.AddedTags)
+			{
+				GatherSubscriptions(CurrentTag, AddedSubscriptions);
+			}
+			for(const FGameplayTag& CurrentTag : Delta.RemovedTags)
+			{
+				GatherSubscriptions(CurrentTag, RemovedSubscriptions);
+			}
+		}
+
+		UObject* OwningObject = Object;
+		
+		if(DoesObjectImplementInterface())
+		{
+			II_ObjectTagsCommunication::Execute_OwningTagsBatchUpdated(Object, Delta, Modifier);
+		}
+
+		for(int32 CurrentListener = 0; CurrentListener < ListenerEntries.Num(); CurrentListener++)
+		{
+			const FObjectTagListener& ListenerEntry = ListenerEntries[CurrentListener];
+			if(!ListenerEntry.Listener || !ListenerEntry.bImplementsInterface)
+			{
+				continue;
+			}
+
+			UObject* Listener = ListenerEntry.Listener;
+			
+			II_ObjectTagsCommunication::Execute_ListeningObjectTagsBatchUpdated(Listener, Delta, Object, Modifier);
+
+			if(!ListenerEntries.IsValidIndex(CurrentListener) || ListenerEntries[CurrentListener].Listener != Listener)
+			{
+				CurrentListener--;
+			}
+		}
+
+		NotifySubscriptions(OwningObject, AddedSubscriptions, Added, Modifier, Delta.Value, Delta.Duration);
+		NotifySubscriptions(OwningObject, RemovedSubscriptions, Removed, Modifier, 0, 0);
 	}
 };
 
+/**What blueprints get from UObjectTags_Subsystem::GetObjectTags.
+ * The views below are only filled in on that copy, so the entries
+ * the subsystem stores don't pay for them.*/
+USTRUCT(BlueprintType)
+struct FObjectTag : public FObjectTagEntry
+{
+	GENERATED_BODY()
+
+	/**Blueprint view of @TagIndices and @TagValues.
+	 * Keep in mind, you should always use GetObjectTags,
+	 * as that will also fetch any external tags.*/
+	UPROPERTY(Category = "Object Tags", BlueprintReadOnly)
+	TMap<FGameplayTag, float> TagsAndValues;
+
+	/**Always empty, only kept so blueprints that read it keep compiling.
+	 * Reading the history is too slow to do for every GetObjectTags,
+	 * use UObjectTags_Subsystem::GetObjectTagHistory instead.*/
+	UPROPERTY(Category = "DEVELOPMENT", VisibleAnywhere, BlueprintReadOnly)
+	TArray<FObjectTagHistory> TagHistory;
+
+	/**Blueprint view of @ListenerEntries.*/
+	UPROPERTY(Category = "Object Tags", BlueprintReadOnly)
+	TArray<TObjectPtr<UObject>> Listeners;
+};
+
+inline FObjectTag FObjectTagEntry::MakeBlueprintCopy() const
+{
+	FObjectTag Copy;
+	static_cast<FObjectTagEntry&>(Copy) = *this;
+	Copy.TagsAndValues = GetTagsAndValues();
+	Copy.Listeners.Reserve(ListenerEntries.Num());
+	for(const FObjectTagListener& CurrentListener : ListenerEntries)
+	{
+		Copy.Listeners.Add(CurrentListener.Listener);
+	}
+	return Copy;
+}
+
+/**Reverse index entry for a single tag, so we can find every object
+ * that has a tag without walking the whole ObjectTags map.*/
+struct FObjectTagReverseIndexEntry
+{
+	/**Objects that have exactly this tag.*/
+	TSet<TWeakObjectPtr<UObject>> ExactObjects;
+
+	/**Objects that have this tag or any of its children,
+	 * and how many of those tags each object has.*/
+	TMap<TWeakObjectPtr<UObject>, int32> HierarchyObjects;
+};
+
 UCLASS()
-class OBJECTTAGS_API UObjectTags_Subsystem : public UGameInstanceSubsystem
+class OBJECTTAGS_API UObjectTags_Subsystem : public UGameInstanceSubsystem, public FTickableGameObject
 {
 	GENERATED_BODY()
 
 public:
 
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
 
 	static UObjectTags_Subsystem* Get();
 
@@ -139,15 +696,75 @@ public:
 	 * worthwhile seeing if it's just an editor problem, especially with how much
 	 * work I was losing from the editor crashing.
 	 * As a workaround, a TMap will suffice. Even though we are storing the UObject
-	 * reference twice now, it's so minor, it won't have any real impact on memory.*/
-	UPROPERTY(Category = "Object Tags", BlueprintReadOnly, SaveGame)
-	TMap<TObjectPtr<UObject>, FObjectTag> ObjectTags;
+	 * reference twice now, it's so minor, it won't have any real impact on memory.
+	 * Not SaveGame, use SaveTagState and LoadTagState to persist this.*/
+	UPROPERTY(Category = "Object Tags", BlueprintReadOnly)
+	TMap<TObjectPtr<UObject>, FObjectTagEntry> ObjectTags;
+
+	/**Tag to objects lookup, indexed by the interned tag index.
+	 * Kept up to date whenever a tag is added to or removed from an object.*/
+	TArray<FObjectTagReverseIndexEntry> TagReverseIndex;
+
+	/**Bumped every time the tags or values of any object change,
+	 * used to know when the @Snapshot has to be republished.*/
+	uint32 StateRevision = 0;
+
+	/**Read by the _AnyThread functions, published at the end of every tick that changed something.*/
+	FObjectTagsSnapshot Snapshot;
+
+	/**Removes temporary tags once their duration runs out.
+	 * Advanced by Tick, so durations pause along with the game.*/
+	FObjectTagExpiryScheduler TagExpiryScheduler;
 
 	/**Get the tags the system has stored for the object.
-	 * TODO: Investigate why this is much more expensive in 5.4*/
+	 * This returns a full copy, including listeners, relationships and timers.
+	 * The history is left out, see GetObjectTagHistory.
+	 * Native code should use FindObjectTags instead.*/
 	UFUNCTION(Category = "Object Tags", BlueprintCallable, meta=(DefaultToSelf = "Object"))
 	static FObjectTag GetObjectTags(UObject* Object);
 
+	/**Native, read-only view of the tags the system has stored for the object.
+	 * Does not copy or allocate anything. Returns nullptr if the object isn't tracked.
+	 * The pointer is only valid until the next time tags are added or removed.*/
+	static const FObjectTagEntry* FindObjectTags(UObject* Object);
+
+	/**Native, read-only view of every tracked object.*/
+	static const TMap<TObjectPtr<UObject>, FObjectTagEntry>* GetAllObjectTags();
+
+	/**Write every objects tags, values, remaining durations and relationships
+	 * into the compact save format (see ObjectTags_SaveData.h).
+	 * Listeners, subscriptions and history are not saved.
+	 * Objects are identified by their path, so only objects that can be
+	 * found again by path (placed actors, assets, etc.) are saved.
+	 * Runtime spawned objects and anything inside them are skipped.
+	 * Returns how many objects were written.*/
+	int32 SaveTagState(TArray<uint8>& OutData) const;
+
+	/**Replace the current tag state with the @Data written by SaveTagState.
+	 * No tag events are broadcast, listeners on existing objects are kept.
+	 * Returns false if the data is corrupt or from a newer version,
+	 * the current state is left untouched in that case.*/
+	bool LoadTagState(const TArray<uint8>& Data);
+
+	UFUNCTION(Category = "Object Tags|Save", BlueprintCallable)
+	static bool SaveObjectTagsToBytes(TArray<uint8>& OutData);
+
+	UFUNCTION(Category = "Object Tags|Save", BlueprintCallable)
+	static bool LoadObjectTagsFromBytes(const TArray<uint8>& Data);
+
+	/**History of every tag change for the @Object that is still in the history buffer.
+	 * Debugging only, do not use for gameplay. Always empty in shipping builds.*/
+	UFUNCTION(Category = "DEVELOPMENT", BlueprintCallable, meta=(DefaultToSelf = "Object"))
+	static TArray<FObjectTagHistory> GetObjectTagHistory(UObject* Object);
+
+	/**Get every tag and its value the system has stored for the object.*/
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, BlueprintPure, meta=(DefaultToSelf = "Object"))
+	static TMap<FGameplayTag, float> GetObjectTagsAndValues(UObject* Object);
+
+	/**Get the tags the system has stored for the object as a container.*/
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, BlueprintPure, meta=(DefaultToSelf = "Object"))
+	static FGameplayTagContainer GetObjectTagsAsContainer(UObject* Object);
+
 	/**Adds @TagsToAdd onto the object, triggering listener events along the way.
 	 * If the object does not exist in the @ObjectTags array, it'll get added.
 	 * @Duration Tags can be applied temporarily, if this value is above 0,
@@ -169,13 +786,51 @@ public:
 	UFUNCTION(Category = "Object Tags", BlueprintCallable, meta=(DefaultToSelf = "Modifier"))
 	static bool RemoveTagsFromObject(FGameplayTagContainer TagsToRemove, UObject* Object, UObject* Modifier);
 
+	/**Bulk version of AddTagToObject. Every tag is applied to every object first,
+	 * then each objects ability system is synced once and each object and its
+	 * listeners receive a single OwningTagsBatchUpdated/ListeningObjectTagsBatchUpdated
+	 * event with everything that changed, instead of one event per tag.*/
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, meta=(DefaultToSelf = "Modifier"))
+	static bool AddTagsToObjects(FGameplayTagContainer TagsToAdd, TArray<UObject*> Objects, UObject* Modifier, float Value = 1, float Duration = 0);
+
+	/**Bulk version of RemoveTagsFromObject, see AddTagsToObjects.*/
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, meta=(DefaultToSelf = "Modifier"))
+	static bool RemoveTagsFromObjects(FGameplayTagContainer TagsToRemove, TArray<UObject*> Objects, UObject* Modifier);
+
 	UFUNCTION(Category = "Object Tags", BlueprintCallable, BlueprintPure, meta=(DefaultToSelf = "Object"))
 	static bool DoesObjectHaveTag(FGameplayTag Tag, UObject* Object);
 
+	/**How many seconds are left before the temporary @Tag is removed from the @Object.
+	 * Returns -1 if the tag isn't temporary.*/
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, BlueprintPure, meta=(DefaultToSelf = "Object"))
+	static float GetTagRemainingTime(FGameplayTag Tag, UObject* Object);
+
 	/**Gets the value of the @Tag that has been assigned to the @Object*/
 	UFUNCTION(Category = "Object Tags", BlueprintCallable, BlueprintPure, meta=(DefaultToSelf = "Object"))
 	static float GetTagValueFromObject(FGameplayTag Tag, UObject* Object);
 
+	/**Thread safe version of DoesObjectHaveTag, reading from the snapshot
+	 * published at the end of the last game thread tick.
+	 * Changes made this frame won't be visible yet.*/
+	static bool DoesObjectHaveTag_AnyThread(FGameplayTag Tag, const UObject* Object);
+
+	/**Thread safe version of GetTagValueFromObject, see DoesObjectHaveTag_AnyThread.*/
+	static float GetTagValueFromObject_AnyThread(FGameplayTag Tag, const UObject* Object);
+
+	/**Get every object that currently has the @Tag.
+	 * If @ExactMatch is false, objects with any child of the @Tag are
+	 * returned as well, so "State" also finds objects with "State.Burning".*/
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, BlueprintPure)
+	static TArray<UObject*> GetObjectsWithTag(FGameplayTag Tag, bool ExactMatch = false);
+
+	/**Get every object that has at least one of the @Tags.*/
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, BlueprintPure)
+	static TArray<UObject*> GetObjectsWithAnyTags(FGameplayTagContainer Tags, bool ExactMatch = false);
+
+	/**Get every object that has all of the @Tags.*/
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, BlueprintPure)
+	static TArray<UObject*> GetObjectsWithAllTags(FGameplayTagContainer Tags, bool ExactMatch = false);
+
 	/**Add a listener for another objects tag updates*/
 	UFUNCTION(Category = "Object Tags", BlueprintCallable, meta=(DefaultToSelf = "Listener"))
 	static bool AddListenerToObject(UObject* Listener, UObject* OtherObject);
@@ -183,10 +838,121 @@ public:
 	UFUNCTION(Category = "Object Tags", BlueprintCallable, meta=(DefaultToSelf = "Listener"))
 	static bool RemoveListenerForObject(UObject* Listener, UObject* OtherObject);
 
-	/**Called when garbage collector goes off.
-	 * This will go through the @ObjectTags array and
-	 * remove any indexes that have an invalid object.*/
-	void CleanupObjectTagArray();
+	/**Add a listener for a single tag on another object. Unlike AddListenerToObject,
+	 * the @Listener is only told about changes to the @Tag.
+	 * If @ExactMatch is false, changes to any child of the @Tag are included.*/
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, meta=(DefaultToSelf = "Listener"))
+	static bool AddTagListenerToObject(UObject* Listener, UObject* OtherObject, FGameplayTag Tag, bool ExactMatch = true);
+
+	UFUNCTION(Category = "Object Tags", BlueprintCallable, meta=(DefaultToSelf = "Listener"))
+	static bool RemoveTagListenerForObject(UObject* Listener, UObject* OtherObject, FGameplayTag Tag);
+
+	/**Native subscription to a single tag on the @Object. The @Delegate is called
+	 * directly, without any interface calls, and only for changes to the @Tag
+	 * (or its children if @ExactMatch is false).
+	 * Returns a handle to pass to UnsubscribeFromObject.*/
+	static FDelegateHandle SubscribeToTag(UObject* Object, FGameplayTag Tag, FOnObjectTagChanged Delegate, bool ExactMatch = true);
+
+	/**Native subscription to every tag on the @Object that matches the @TagQuery.*/
+	static FDelegateHandle SubscribeToTagQuery(UObject* Object, const FGameplayTagQuery& TagQuery, FOnObjectTagChanged Delegate);
+
+	static bool UnsubscribeFromObject(UObject* Object, FDelegateHandle Handle);
+
+	/**Remove the subscriptions in the @Object's @Subscriptions that match the @Predicate.
+	 * While subscribers are being notified they are only marked as removed, so the
+	 * references gathered for the broadcast stay valid. Returns how many matched.*/
+	int32 RemoveSubscriptions(UObject* Object, TArray<FObjectTagSubscription>& Subscriptions, TFunctionRef<bool(const FObjectTagSubscription&)> Predicate);
+
+	/**Remove the subscriptions that RemoveSubscriptions marked.*/
+	void PurgeRemovedSubscriptions();
+
+	/**How many FObjectTagEntry::NotifySubscriptions calls are running, subscribers can cause nested ones.*/
+	int32 SubscriptionNotifyDepth = 0;
+
+	/**Objects with subscriptions waiting for PurgeRemovedSubscriptions.*/
+	TArray<TWeakObjectPtr<UObject>> ObjectsWithRemovedSubscriptions;
+
+	/**Get the entry for the @Object, creating an empty one if it isn't tracked yet.*/
+	FObjectTagEntry& FindOrAddObjectTag(UObject* Object);
+
+	/**Get the cached ability system of the @ObjectTag, resolving it if needed.
+	 * @bOutNewlyResolved is true if it was found just now, in which case
+	 * it hasn't been told about any of the objects tags yet.*/
+	UAbilitySystemComponent* FindAbilitySystemComponent(FObjectTagEntry& ObjectTag, bool& bOutNewlyResolved);
+
+	/**Mirror tag changes on the @ObjectTag as loose gameplay tags on its ability system.
+	 * With ObjectTags.DeferAbilitySystemSync this is queued until FlushLooseTags.*/
+	void SyncLooseTags(FObjectTagEntry& ObjectTag, TConstArrayView<FGameplayTag> AddedTags, TConstArrayView<FGameplayTag> RemovedTags);
+
+	/**Send the changes to the @AbilitySystemComponent, or queue them with ObjectTags.DeferAbilitySystemSync.*/
+	void QueueLooseTags(UAbilitySystemComponent* AbilitySystemComponent, TConstArrayView<FGameplayTag> AddedTags, TConstArrayView<FGameplayTag> RemovedTags);
+
+	/**Give an ability system that was just resolved every tag the @ObjectTag has,
+	 * except the @IgnoredTags, which are being removed.*/
+	void CatchUpLooseTags(const FObjectTagEntry& ObjectTag, UAbilitySystemComponent* AbilitySystemComponent, TConstArrayView<FGameplayTag> IgnoredTags);
+
+	static void ApplyLooseTags(UAbilitySystemComponent* AbilitySystemComponent, TConstArrayView<FGameplayTag> AddedTags, TConstArrayView<FGameplayTag> RemovedTags);
+
+	/**Apply every queued loose tag change, once per ability system. Called by Tick.*/
+	void FlushLooseTags();
+
+	/**Net change per tag for each ability system, waiting for FlushLooseTags.*/
+	TMap<TWeakObjectPtr<UAbilitySystemComponent>, TMap<FGameplayTag, int32>> PendingLooseTags;
+
+	/**Bind to the @Object's destruction if it can tell us about it,
+	 * called whenever a new entry is added to @ObjectTags.*/
+	void TrackObjectDestruction(UObject* Object);
+
+	/**Only marks the entry, see FObjectTagEntry::bPendingRemoval.
+	 * Actors can be destroyed from inside a tag broadcast.*/
+	UFUNCTION()
+	void OnTrackedActorDestroyed(AActor* DestroyedActor);
+
+	/**Entries of destroyed actors, removed by ReclaimDestroyedObjects.*/
+	TArray<FSetElementId> PendingRemovals;
+
+	/**Remove every entry in @PendingRemovals. Called at the start of Tick,
+	 * when nothing can be holding on to an entry.*/
+	void ReclaimDestroyedObjects();
+
+	/**Check up to @Budget slots of @ObjectTags for destroyed objects or
+	 * objects nobody cares about anymore, and remove them.
+	 * This replaces a full sweep before every garbage collection,
+	 * which could hitch on large maps.*/
+	void SweepStaleObjects(int32 Budget);
+
+	/**Where SweepStaleObjects continues next frame.*/
+	int32 SweepCursor = 0;
+
+	/**Entries removed since the stats were last updated.*/
+	int32 ReclaimedThisFrame = 0;
+
+#if WITH_EDITOR
+	/**Refresh the cached interface checks after blueprints have been reinstanced.*/
+	void OnObjectsReplaced(const TMap<UObject*, UObject*>& ReplacementMap);
+#endif
+
+	/**Update the reverse index after the @Tag was added to the @Object.*/
+	void AddToReverseIndex(UObject* Object, FGameplayTag Tag);
+
+	/**Update the reverse index after the @Tag was removed from the @Object.*/
+	void RemoveFromReverseIndex(UObject* Object, FGameplayTag Tag);
+
+	/**Remove every tag of the @ObjectTag from the reverse index, used when
+	 * the whole entry is about to be removed. Works after the object was
+	 * garbage collected, see FObjectTagEntry::WeakObject.*/
+	void RemoveObjectFromReverseIndex(const FObjectTagEntry& ObjectTag);
+
+	const FObjectTagReverseIndexEntry* FindReverseIndexEntry(FGameplayTag Tag) const;
+
+	/**Start or refresh the expiry that removes the @Tag from the @Object after @Duration.*/
+	void SetTagTimer(UObject* Object, FGameplayTag Tag, UObject* Modifier, float Duration);
+
+	/**Stop the @Tag from expiring on the @Object, called whenever a tag is removed.*/
+	void ClearTagTimer(UObject* Object, FGameplayTag Tag);
+
+	/**Remove every temporary tag whose duration ran out this frame.*/
+	void ExpireTags(float DeltaTime);
 
 	/**Get all the tags in the @Container that conflict with the tag
 	 * that the @Relationship wants to apply.
@@ -206,9 +972,17 @@ public:
 	UFUNCTION(Category = "ObjectTags|Tag Relationship", BlueprintCallable, BlueprintPure)
 	static bool HasRequiredTags(TSubclassOf<UO_TagRelationship> Relationship, FGameplayTagContainer Container);
 
-#if WITH_EDITOR
-	
+	/**Stop tracking every relationship on the @ObjectTag that is blocked by
+	 * any of the @NewTagIndices, and gather their tags into @OutTagsToRemove.*/
+	void RemoveBlockedRelationships(FObjectTagEntry& ObjectTag, TConstArrayView<uint16> NewTagIndices, FGameplayTagContainer& OutTagsToRemove);
+
 protected:
+
+	/**Prints how much memory the tag storage uses per object, compared to
+	 * storing the same tags in a TMap<FGameplayTag, float> per object.*/
+	static void MemoryReportConsoleCommand();
+
+#if WITH_EDITOR
 	
 	static AActor* GetActorForConsoleCommand();
 	
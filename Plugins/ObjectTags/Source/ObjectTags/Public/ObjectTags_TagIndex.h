@@ -0,0 +1,54 @@
+﻿// Copyright (C) Varian Daemon. All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+/**Interns gameplay tags into small, dense integer indices.
+ * The object tags subsystem stores every objects tags as a sorted
+ * array of these indices instead of a TMap per object, which is both
+ * a lot smaller and a lot faster to compare.
+ * An index is handed out once and never changes for the rest of the session.*/
+class OBJECTTAGS_API FObjectTagIndexTable
+{
+public:
+
+	static constexpr uint16 InvalidIndex = MAX_uint16;
+
+	static FObjectTagIndexTable& Get();
+
+	/**Seed the table with every tag the gameplay tags manager knows about,
+	 * so the common tags get their index up front instead of on first use.*/
+	void Initialize();
+
+	/**Get the index for the @Tag, interning it if this is the first time
+	 * we've seen it. Returns InvalidIndex for invalid tags.*/
+	uint16 FindOrAddIndex(const FGameplayTag& Tag);
+
+	/**Get the index for the @Tag without interning it.
+	 * Returns InvalidIndex if the tag has never been interned.*/
+	uint16 FindIndex(const FGameplayTag& Tag) const;
+
+	FGameplayTag GetTag(uint16 Index) const
+	{
+		return IndexToTag.IsValidIndex(Index) ? IndexToTag[Index] : FGameplayTag::EmptyTag;
+	}
+
+	/**Index of the direct parent of the tag at @Index,
+	 * or InvalidIndex if it's a root tag.*/
+	uint16 GetParentIndex(uint16 Index) const
+	{
+		return ParentIndices.IsValidIndex(Index) ? ParentIndices[Index] : InvalidIndex;
+	}
+
+	int32 Num() const { return IndexToTag.Num(); }
+
+private:
+
+	TMap<FGameplayTag, uint16> TagToIndex;
+	TArray<FGameplayTag> IndexToTag;
+
+	/**Parent of every interned tag, parents are always interned before their children.*/
+	TArray<uint16> ParentIndices;
+};
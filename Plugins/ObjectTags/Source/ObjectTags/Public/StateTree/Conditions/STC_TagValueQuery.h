@@ -29,6 +29,42 @@ struct FTagValueQueryEntry
 	TEnumAsByte<ETagValueQueryComparitor> Comparison = Equals;
 };
 
+struct FObjectTagEntry;
+
+/**Flattened version of a TagValueQuery, with the tags already resolved to
+ * interned indices and sorted the same way FObjectTagEntry stores them,
+ * so evaluating it is a single walk over the objects tags.*/
+struct OBJECTTAGS_API FCompiledTagValueQuery
+{
+	struct FInstruction
+	{
+		uint16 TagIndex = 0;
+		TEnumAsByte<ETagValueQueryComparitor> Comparison = Equals;
+		float Operand = 0;
+	};
+
+	TArray<FInstruction, TInlineAllocator<4>> Instructions;
+
+	/**If true, the first failing instruction returns false.
+	 * Otherwise the first passing instruction returns true.*/
+	bool bAllMustMatch = true;
+
+	bool bCompiled = false;
+
+	/**Hash of the entries this was compiled from, see HashSource.*/
+	uint32 SourceHash = 0;
+
+	void Compile(const TArray<FTagValueQueryEntry>& Entries, bool AllMustMatch);
+
+	/**Compile again if the entries changed since the last compile,
+	 * which happens when they are bound to state tree parameters.*/
+	void CompileIfChanged(const TArray<FTagValueQueryEntry>& Entries, bool AllMustMatch);
+
+	static uint32 HashSource(const TArray<FTagValueQueryEntry>& Entries, bool AllMustMatch);
+
+	bool Evaluate(const FObjectTagEntry& ObjectTag) const;
+};
+
 /**
  * 
  */
@@ -54,4 +90,15 @@ public:
 	TArray<FTagValueQueryEntry> TagValueQuery;
 
 	virtual bool TestCondition(FStateTreeExecutionContext& Context) const override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+
+	/**Blueprint conditions don't get a link callback, and bound properties
+	 * can change between tests, so this is compiled whenever the entries
+	 * differ from the ones it was compiled from.*/
+	mutable FCompiledTagValueQuery CompiledQuery;
 };
@@ -0,0 +1,194 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/FactBenchmark.h"
+
+#include "GameplayTagsManager.h"
+#include "Core/FactSubSystem.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(TagFactsBenchmarkLog, Log, All)
+
+void FFactBenchmark::RunGetFactValueBenchmark(const TArray<FString>& Args)
+{
+	const int32 RequestedFacts = Args.IsValidIndex(0) ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 50000;
+	const int32 Iterations = Args.IsValidIndex(1) ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 100;
+
+	UFactSubSystem* FactSubSystem = UFactSubSystem::Get();
+	if(!FactSubSystem)
+	{
+		UE_LOG(TagFactsBenchmarkLog, Warning, TEXT("TagFacts benchmark needs a running game instance"));
+		return;
+	}
+
+	const TArray<FGameplayTag> Tags = GetBenchmarkTags(RequestedFacts);
+	if(Tags.IsEmpty())
+	{
+		UE_LOG(TagFactsBenchmarkLog, Warning, TEXT("TagFacts benchmark found no gameplay tags to use"));
+		return;
+	}
+
+	//Keep the current facts so the benchmark doesn't leave anything behind.
+	const TSet<FS_Fact> OriginalFacts = FactSubSystem->GetFacts();
+
+	TSet<FS_Fact> LegacyFacts;
+	TSet<FS_Fact> NewFacts;
+	for(int32 CurrentFact = 0; CurrentFact < Tags.Num(); CurrentFact++)
+	{
+		LegacyFacts.Add(FS_Fact({Tags[CurrentFact], CurrentFact}));
+		NewFacts.Add(FS_Fact({Tags[CurrentFact], CurrentFact}));
+	}
+	FactSubSystem->SetFacts(NewFacts);
+
+	const double Operations = static_cast<double>(Tags.Num()) * Iterations;
+
+	//Used so the compiler can't throw the work away.
+	int64 ValueSum = 0;
+
+	double StartTime = FPlatformTime::Seconds();
+	for(int32 CurrentIteration = 0; CurrentIteration < Iterations; CurrentIteration++)
+	{
+		for(const FGameplayTag& CurrentTag : Tags)
+		{
+			if(const FS_Fact* FoundFact = LegacyFacts.Find(FS_Fact({CurrentTag})))
+			{
+				ValueSum += FoundFact->Value;
+			}
+		}
+	}
+	const double LegacyTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for(int32 CurrentIteration = 0; CurrentIteration < Iterations; CurrentIteration++)
+	{
+		for(const FGameplayTag& CurrentTag : Tags)
+		{
+			ValueSum += FactSubSystem->GetFactValue(CurrentTag);
+		}
+	}
+	const double TableTime = FPlatformTime::Seconds() - StartTime;
+
+	FactSubSystem->SetFacts(OriginalFacts);
+
+	UE_LOG(TagFactsBenchmarkLog, Display, TEXT("TagFacts GetFactValue benchmark: %d facts (%d requested), %d iterations (%lld sum)"),
+		Tags.Num(), RequestedFacts, Iterations, ValueSum);
+	UE_LOG(TagFactsBenchmarkLog, Display, TEXT("  TSet<FS_Fact>: %8.1f ns/op"), LegacyTime * 1e9 / Operations);
+	UE_LOG(TagFactsBenchmarkLog, Display, TEXT("  Fact table:    %8.1f ns/op"), TableTime * 1e9 / Operations);
+}
+
+void FFactBenchmark::RunSaveBenchmark(const TArray<FString>& Args)
+{
+	const int32 RequestedFacts = Args.IsValidIndex(0) ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+	const int32 ChangedFacts = Args.IsValidIndex(1) ? FMath::Max(FCString::Atoi(*Args[1]), 0) : 100;
+
+	UFactSubSystem* FactSubSystem = UFactSubSystem::Get();
+	if(!FactSubSystem)
+	{
+		UE_LOG(TagFactsBenchmarkLog, Warning, TEXT("TagFacts benchmark needs a running game instance"));
+		return;
+	}
+
+	const TArray<FGameplayTag> Tags = GetBenchmarkTags(RequestedFacts);
+	if(Tags.IsEmpty())
+	{
+		UE_LOG(TagFactsBenchmarkLog, Warning, TEXT("TagFacts benchmark found no gameplay tags to use"));
+		return;
+	}
+
+	//Keep the current facts so the benchmark doesn't leave anything behind.
+	const TSet<FS_Fact> OriginalFacts = FactSubSystem->GetFacts();
+
+	TSet<FS_Fact> NewFacts;
+	for(int32 CurrentFact = 0; CurrentFact < Tags.Num(); CurrentFact++)
+	{
+		NewFacts.Add(FS_Fact({Tags[CurrentFact], CurrentFact}));
+	}
+	FactSubSystem->SetFacts(NewFacts);
+
+	//Full set, the way the SaveGame property writes it: every fact, every save.
+	TArray<uint8> FullData;
+	double StartTime = FPlatformTime::Seconds();
+	{
+		FMemoryWriter Writer(FullData, true);
+		TSet<FS_Fact> AllFacts = FactSubSystem->GetFacts();
+		int32 FactCount = AllFacts.Num();
+		Writer << FactCount;
+		for(FS_Fact& CurrentFact : AllFacts)
+		{
+			FS_Fact::StaticStruct()->SerializeItem(Writer, &CurrentFact, nullptr);
+		}
+	}
+	const double FullTime = FPlatformTime::Seconds() - StartTime;
+
+	TArray<uint8> SnapshotData;
+	StartTime = FPlatformTime::Seconds();
+	FactSubSystem->SaveFactSnapshot(SnapshotData);
+	const double SnapshotTime = FPlatformTime::Seconds() - StartTime;
+
+	for(int32 CurrentChange = 0; CurrentChange < ChangedFacts; CurrentChange++)
+	{
+		FactSubSystem->IncrementFact(Tags[CurrentChange % Tags.Num()]);
+	}
+
+	TArray<uint8> DeltaData;
+	StartTime = FPlatformTime::Seconds();
+	FactSubSystem->SaveFactDelta(DeltaData);
+	const double DeltaTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	const bool bLoaded = FactSubSystem->LoadFactSave(SnapshotData, DeltaData);
+	const double LoadTime = FPlatformTime::Seconds() - StartTime;
+
+	FactSubSystem->SetFacts(OriginalFacts);
+
+	UE_LOG(TagFactsBenchmarkLog, Display, TEXT("TagFacts save benchmark: %d facts (%d requested), %d changed between saves%s"),
+		Tags.Num(), RequestedFacts, ChangedFacts, bLoaded ? TEXT("") : TEXT(" (LOAD FAILED)"));
+	UE_LOG(TagFactsBenchmarkLog, Display, TEXT("  Full set: %10d bytes, %8.3f ms"), FullData.Num(), FullTime * 1e3);
+	UE_LOG(TagFactsBenchmarkLog, Display, TEXT("  Snapshot: %10d bytes, %8.3f ms"), SnapshotData.Num(), SnapshotTime * 1e3);
+	UE_LOG(TagFactsBenchmarkLog, Display, TEXT("  Delta:    %10d bytes, %8.3f ms"), DeltaData.Num(), DeltaTime * 1e3);
+	UE_LOG(TagFactsBenchmarkLog, Display, TEXT("  Load snapshot and delta: %8.3f ms"), LoadTime * 1e3);
+}
+
+void FFactBenchmark::RegisterBenchmarkTags()
+{
+	int32 TagCount = 0;
+	if(!FParse::Value(FCommandLine::Get(), TEXT("TagFactsBenchmarkTags="), TagCount) || TagCount <= 0)
+	{
+		return;
+	}
+
+	UGameplayTagsManager::OnLastChanceToAddNativeTags().AddLambda([TagCount]()
+	{
+		UGameplayTagsManager& TagsManager = UGameplayTagsManager::Get();
+		for(int32 CurrentTag = 0; CurrentTag < TagCount; CurrentTag++)
+		{
+			TagsManager.AddNativeGameplayTag(FName(*FString::Printf(TEXT("TagFactsBenchmark.Fact%d"), CurrentTag)));
+		}
+		UE_LOG(TagFactsBenchmarkLog, Display, TEXT("Registered %d benchmark gameplay tags"), TagCount);
+	});
+}
+
+TArray<FGameplayTag> FFactBenchmark::GetBenchmarkTags(int32 Count)
+{
+	FGameplayTagContainer AllTags;
+	UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, false);
+
+	TArray<FGameplayTag> Tags;
+	Tags.Reserve(FMath::Min(Count, AllTags.Num()));
+	for(const FGameplayTag& CurrentTag : AllTags)
+	{
+		if(Tags.Num() >= Count)
+		{
+			break;
+		}
+		Tags.Add(CurrentTag);
+	}
+
+	if(Tags.Num() < Count)
+	{
+		UE_LOG(TagFactsBenchmarkLog, Warning, TEXT("Only %d gameplay tags are registered, %d were requested. Start the game with -TagFactsBenchmarkTags=%d to benchmark at the requested size"),
+			Tags.Num(), Count, Count);
+	}
+
+	return Tags;
+}
@@ -0,0 +1,37 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+/**Console driven benchmarks for the fact system.
+ * Results are printed to the log in nanoseconds per operation.*/
+class FFactBenchmark
+{
+public:
+
+	/**TagFacts.Benchmark.GetFactValue [Facts] [Iterations]
+	 * Compares GetFactValue against the old TSet<FS_Fact> lookup.
+	 * Facts are made from registered gameplay tags, most projects don't have
+	 * nearly enough, so start with -TagFactsBenchmarkTags=[Facts] to add them.*/
+	static void RunGetFactValueBenchmark(const TArray<FString>& Args);
+
+	/**TagFacts.Benchmark.Save [Facts] [ChangedFacts]
+	 * Compares saving every fact as a full set, like the SaveGame Facts
+	 * property does, against a journal snapshot and a delta after
+	 * [ChangedFacts] facts were changed. Reports size and time.
+	 * Needs -TagFactsBenchmarkTags like the GetFactValue benchmark.*/
+	static void RunSaveBenchmark(const TArray<FString>& Args);
+
+	/**If the game was started with -TagFactsBenchmarkTags=N, register N native
+	 * TagFactsBenchmark.Fact* tags for the benchmarks to use as facts.
+	 * Has to be called before the gameplay tags manager is done adding native tags.*/
+	static void RegisterBenchmarkTags();
+
+private:
+
+	/**Get up to @Count registered gameplay tags to use as facts.
+	 * Warns if there are fewer than that, since the results would be meaningless.*/
+	static TArray<FGameplayTag> GetBenchmarkTags(int32 Count);
+};
@@ -0,0 +1,120 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/FactConcurrentView.h"
+
+FFactConcurrentView::FSlotTable::FSlotTable(int32 InCapacity)
+	: Capacity(InCapacity)
+	, Keys(MakeUnique<std::atomic<uint64>[]>(InCapacity))
+	, Slots(MakeUnique<int32[]>(InCapacity))
+{
+	for(int32 CurrentIndex = 0; CurrentIndex < Capacity; CurrentIndex++)
+	{
+		Keys[CurrentIndex].store(0, std::memory_order_relaxed);
+	}
+}
+
+void FFactConcurrentView::FSlotTable::Insert(uint64 Key, int32 Slot)
+{
+	for(uint32 Index = HashKey(Key) & (Capacity - 1);; Index = (Index + 1) & (Capacity - 1))
+	{
+		if(Keys[Index].load(std::memory_order_relaxed) == 0)
+		{
+			Slots[Index] = Slot;
+			Keys[Index].store(Key, std::memory_order_release);
+			Num++;
+			return;
+		}
+	}
+}
+
+int32 FFactConcurrentView::FSlotTable::Find(uint64 Key) const
+{
+	//Tables are never more than half full, so there is always an empty key to stop at.
+	for(uint32 Index = HashKey(Key) & (Capacity - 1);; Index = (Index + 1) & (Capacity - 1))
+	{
+		const uint64 FoundKey = Keys[Index].load(std::memory_order_acquire);
+		if(FoundKey == Key)
+		{
+			return Slots[Index];
+		}
+		if(FoundKey == 0)
+		{
+			return INDEX_NONE;
+		}
+	}
+}
+
+FFactConcurrentView::~FFactConcurrentView()
+{
+	for(std::atomic<std::atomic<uint64>*>& Chunk : Chunks)
+	{
+		delete[] Chunk.load();
+	}
+}
+
+void FFactConcurrentView::AddSlot(const FGameplayTag& Tag, int32 Slot)
+{
+	check(IsInGameThread());
+	if(!ensureMsgf(Slot < MaxChunks * ChunkSize, TEXT("TagFacts ran out of thread safe fact slots")))
+	{
+		return;
+	}
+
+	//The chunk has to exist before the slot can be found.
+	std::atomic<std::atomic<uint64>*>& Chunk = Chunks[Slot >> ChunkShift];
+	if(!Chunk.load(std::memory_order_relaxed))
+	{
+		std::atomic<uint64>* NewChunk = new std::atomic<uint64>[ChunkSize];
+		for(int32 CurrentIndex = 0; CurrentIndex < ChunkSize; CurrentIndex++)
+		{
+			NewChunk[CurrentIndex].store(0, std::memory_order_relaxed);
+		}
+		Chunk.store(NewChunk, std::memory_order_release);
+	}
+
+	const uint64 Key = MakeKey(Tag);
+	AddedKeys.Emplace(Key, Slot);
+
+	FSlotTable* Table = CurrentTable.load(std::memory_order_relaxed);
+	if(!Table || (Table->Num + 1) * 2 > Table->Capacity)
+	{
+		//Fill a bigger table before anyone can see it, then swap it in.
+		TUniquePtr<FSlotTable> NewTable = MakeUnique<FSlotTable>(Table ? Table->Capacity * 2 : 1024);
+		for(const TPair<uint64, int32>& CurrentKey : AddedKeys)
+		{
+			NewTable->Insert(CurrentKey.Key, CurrentKey.Value);
+		}
+		CurrentTable.store(NewTable.Get(), std::memory_order_release);
+		Tables.Add(MoveTemp(NewTable));
+		return;
+	}
+
+	Table->Insert(Key, Slot);
+}
+
+bool FFactConcurrentView::Read(const FGameplayTag& Tag, int32& OutValue) const
+{
+	OutValue = 0;
+	const FSlotTable* Table = CurrentTable.load(std::memory_order_acquire);
+	if(!Table || !Tag.IsValid())
+	{
+		return false;
+	}
+
+	const int32 Slot = Table->Find(MakeKey(Tag));
+	if(Slot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const std::atomic<uint64>* Chunk = Chunks[Slot >> ChunkShift].load(std::memory_order_acquire);
+	const uint64 Packed = Chunk[Slot & ChunkMask].load(std::memory_order_acquire);
+	if((Packed >> 32) == 0)
+	{
+		return false;
+	}
+
+	OutValue = static_cast<int32>(static_cast<uint32>(Packed));
+	return true;
+}
@@ -0,0 +1,675 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/FactJournal.h"
+
+#include "Core/FactSubSystem.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(TagFactsSaveLog, Log, All)
+
+static TAutoConsoleVariable<int32> CVarJournalSnapshotThreshold(
+	TEXT("TagFacts.Journal.SnapshotThreshold"),
+	4096,
+	TEXT("Once more facts than this have changed since the last snapshot, ShouldSaveFactSnapshot returns true."),
+	ECVF_Default);
+
+namespace FactSaveData
+{
+	static void WritePacked(FArchive& Ar, uint32 Value)
+	{
+		Ar.SerializeIntPacked(Value);
+	}
+
+	static uint32 ReadPacked(FArchive& Ar)
+	{
+		uint32 Value = 0;
+		Ar.SerializeIntPacked(Value);
+		return Value;
+	}
+
+	/**Every counted element takes at least a byte, so a count larger than
+	 * what is left of the archive can only come from corrupt data.*/
+	static uint32 ReadCount(FArchive& Ar)
+	{
+		const uint32 Count = ReadPacked(Ar);
+		if(Ar.IsError() || Count > static_cast<uint64>(FMath::Max<int64>(Ar.TotalSize() - Ar.Tell(), 0)))
+		{
+			Ar.SetError();
+			return 0;
+		}
+		return Count;
+	}
+
+	/**Zigzag, so small negative values pack as small as small positive ones.*/
+	static void WriteValue(FArchive& Ar, int32 Value)
+	{
+		WritePacked(Ar, (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31));
+	}
+
+	static int32 ReadValue(FArchive& Ar)
+	{
+		const uint32 Packed = ReadPacked(Ar);
+		return static_cast<int32>(Packed >> 1) ^ -static_cast<int32>(Packed & 1);
+	}
+
+	static void WriteHeader(FArchive& Ar, EFactSaveType Type)
+	{
+		uint32 SaveMagic = Magic;
+		uint16 Version = static_cast<uint16>(EFactSaveVersion::Latest);
+		uint8 SaveType = static_cast<uint8>(Type);
+		Ar << SaveMagic;
+		Ar << Version;
+		Ar << SaveType;
+	}
+
+	static bool ReadHeader(FArchive& Ar, EFactSaveType ExpectedType, uint16& Version)
+	{
+		uint32 SaveMagic = 0;
+		Version = 0;
+		uint8 SaveType = 0;
+		Ar << SaveMagic;
+		Ar << Version;
+		Ar << SaveType;
+		if(Ar.IsError() || SaveMagic != Magic || SaveType != static_cast<uint8>(ExpectedType)
+			|| Version < static_cast<uint16>(EFactSaveVersion::Initial) || Version > static_cast<uint16>(EFactSaveVersion::Latest))
+		{
+			UE_LOG(TagFactsSaveLog, Warning, TEXT("Fact save data is corrupt, from a newer version (%u) or of the wrong type (%u)"),
+				Version, SaveType);
+			return false;
+		}
+		return true;
+	}
+
+	static FGameplayTag ReadTag(FArchive& Ar)
+	{
+		FString TagName;
+		Ar << TagName;
+		//Tags that were removed from the project since the save are dropped.
+		return FGameplayTag::RequestGameplayTag(FName(TagName), false);
+	}
+
+	static void WriteFactValue(FArchive& Ar, const FFactTable& FactTable, EFactValueType Type, int32 RawValue)
+	{
+		uint8 SavedType = static_cast<uint8>(Type);
+		Ar << SavedType;
+		switch(Type)
+		{
+		case EFactValueType::Float:
+			Ar << RawValue;
+			break;
+		case EFactValueType::Bool:
+		case EFactValueType::Bitfield:
+			WritePacked(Ar, static_cast<uint32>(RawValue));
+			break;
+		case EFactValueType::Tag:
+			{
+				//Slots only mean something in this session, save the name instead.
+				FString TagName = FactTable.GetTag(RawValue).ToString();
+				Ar << TagName;
+				break;
+			}
+		default:
+			WriteValue(Ar, RawValue);
+			break;
+		}
+	}
+
+	/**Read a value written by WriteFactValue, or a plain Int from before TypedValues.*/
+	static int32 ReadFactValue(FArchive& Ar, FFactTable& FactTable, uint16 Version, EFactValueType& OutType)
+	{
+		OutType = EFactValueType::Int;
+		if(Version < static_cast<uint16>(EFactSaveVersion::TypedValues))
+		{
+			return ReadValue(Ar);
+		}
+
+		uint8 SavedType = 0;
+		Ar << SavedType;
+		if(SavedType > static_cast<uint8>(EFactValueType::Bitfield))
+		{
+			Ar.SetError();
+			return 0;
+		}
+
+		OutType = static_cast<EFactValueType>(SavedType);
+		switch(OutType)
+		{
+		case EFactValueType::Float:
+			{
+				int32 RawValue = 0;
+				Ar << RawValue;
+				return RawValue;
+			}
+		case EFactValueType::Bool:
+		case EFactValueType::Bitfield:
+			return static_cast<int32>(ReadPacked(Ar));
+		case EFactValueType::Tag:
+			return FactTable.FindOrAddSlot(ReadTag(Ar));
+		default:
+			return ReadValue(Ar);
+		}
+	}
+}
+
+void FFactJournal::Start(bool bInRecordTimeline)
+{
+	Entries.Reset();
+	Timeline.Reset();
+	LastEntryForSlot.Reset();
+	Savepoint = 0;
+	SnapshotGuid = FGuid::NewGuid();
+	StartTime = FPlatformTime::Seconds();
+	bRecordTimeline = bInRecordTimeline;
+}
+
+void FFactJournal::Append(int32 Slot, bool bSet, int32 Value, EFactValueType Type)
+{
+	FFactJournalEntry Entry;
+	Entry.Slot = Slot;
+	Entry.Value = Value;
+	Entry.Type = Type;
+	Entry.bSet = bSet;
+	Entry.Time = FPlatformTime::Seconds() - StartTime;
+
+	if(!LastEntryForSlot.IsValidIndex(Slot))
+	{
+		const int32 OldNum = LastEntryForSlot.Num();
+		LastEntryForSlot.SetNumUninitialized(Slot + 1);
+		for(int32 CurrentSlot = OldNum; CurrentSlot <= Slot; CurrentSlot++)
+		{
+			LastEntryForSlot[CurrentSlot] = INDEX_NONE;
+		}
+	}
+
+	//Deltas only save the last change of every fact, earlier ones would just take up memory.
+	int32& LastEntry = LastEntryForSlot[Slot];
+	if(LastEntry >= Savepoint)
+	{
+		Entries[LastEntry] = Entry;
+	}
+	else
+	{
+		LastEntry = Entries.Add(Entry);
+	}
+	
+	if(bRecordTimeline)
+	{
+		Timeline.Add(Entry);
+	}
+}
+
+void FFactJournal::Truncate(int32 NumEntries, int32 NumTimelineEntries)
+{
+	Entries.SetNum(FMath::Min(NumEntries, Entries.Num()), EAllowShrinking::No);
+	Timeline.SetNum(FMath::Min(NumTimelineEntries, Timeline.Num()), EAllowShrinking::No);
+	Savepoint = FMath::Min(Savepoint, Entries.Num());
+	RebuildLastEntries();
+}
+
+void FFactJournal::Compact()
+{
+	Entries.Reset();
+	LastEntryForSlot.Reset();
+	Savepoint = 0;
+	SnapshotGuid = FGuid::NewGuid();
+}
+
+void FFactJournal::Restore(const FGuid& InSnapshotGuid, TArray<FFactJournalEntry>&& InEntries)
+{
+	Entries = MoveTemp(InEntries);
+	SnapshotGuid = InSnapshotGuid;
+	Savepoint = 0;
+	RebuildLastEntries();
+}
+
+void FFactJournal::RebuildLastEntries()
+{
+	LastEntryForSlot.Reset();
+	for(int32 CurrentEntry = 0; CurrentEntry < Entries.Num(); CurrentEntry++)
+	{
+		const int32 Slot = Entries[CurrentEntry].Slot;
+		while(!LastEntryForSlot.IsValidIndex(Slot))
+		{
+			LastEntryForSlot.Add(INDEX_NONE);
+		}
+		LastEntryForSlot[Slot] = CurrentEntry;
+	}
+}
+
+bool UFactSubSystem::SaveFactSnapshot(TArray<uint8>& OutData)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(SaveFactSnapshot)
+	using namespace FactSaveData;
+
+	//The snapshot would contain changes that can still be aborted,
+	//and folding the journal would lose the point the abort goes back to.
+	if(Transaction.IsActive())
+	{
+		UE_LOG(TagFactsSaveLog, Warning, TEXT("Can't save a fact snapshot during a fact transaction, commit or abort it first"));
+		return false;
+	}
+
+	//The journal is folded into this snapshot, deltas from now on build on top of it.
+	Journal.Compact();
+	
+	OutData.Reset();
+	FMemoryWriter Writer(OutData, true);
+	WriteHeader(Writer, EFactSaveType::Snapshot);
+	
+	FGuid SnapshotGuid = Journal.GetSnapshotGuid();
+	Writer << SnapshotGuid;
+
+	WritePacked(Writer, FactTable.Num());
+	FactTable.ForEachSetSlot([&](int32 Slot)
+	{
+		FString TagName = FactTable.GetTag(Slot).ToString();
+		Writer << TagName;
+		WriteFactValue(Writer, FactTable, FactTable.GetValueType(Slot), FactTable.GetRawValue(Slot));
+	});
+
+	return !Writer.IsError();
+}
+
+bool UFactSubSystem::SaveFactDelta(TArray<uint8>& OutData) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(SaveFactDelta)
+	using namespace FactSaveData;
+
+	OutData.Reset();
+	FMemoryWriter Writer(OutData, true);
+	WriteHeader(Writer, EFactSaveType::Delta);
+
+	FGuid SnapshotGuid = Journal.GetSnapshotGuid();
+	Writer << SnapshotGuid;
+
+	//Only the last change of every fact matters to a save, walk backwards and skip the rest.
+	const TArray<FFactJournalEntry>& Entries = Journal.GetEntries();
+	TBitArray<> WrittenSlots(false, FactTable.NumSlots());
+	TArray<const FFactJournalEntry*> LastChanges;
+	for(int32 CurrentEntry = Entries.Num() - 1; CurrentEntry >= 0; CurrentEntry--)
+	{
+		const FFactJournalEntry& Entry = Entries[CurrentEntry];
+		if(!WrittenSlots[Entry.Slot])
+		{
+			WrittenSlots[Entry.Slot] = true;
+			LastChanges.Add(&Entry);
+		}
+	}
+
+	WritePacked(Writer, LastChanges.Num());
+	for(const FFactJournalEntry* Entry : LastChanges)
+	{
+		FString TagName = FactTable.GetTag(Entry->Slot).ToString();
+		uint8 bSet = Entry->bSet;
+		Writer << TagName;
+		Writer << bSet;
+		WriteFactValue(Writer, FactTable, Entry->Type, Entry->Value);
+	}
+
+	return !Writer.IsError();
+}
+
+bool UFactSubSystem::LoadFactSave(const TArray<uint8>& Snapshot, const TArray<uint8>& Delta)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(LoadFactSave)
+	using namespace FactSaveData;
+
+	//Loading replaces the journal, so an abort would have nothing to go back to.
+	if(Transaction.IsActive())
+	{
+		UE_LOG(TagFactsSaveLog, Warning, TEXT("Can't load a fact save during a fact transaction, commit or abort it first"));
+		return false;
+	}
+
+	FMemoryReader SnapshotReader(Snapshot, true);
+	uint16 SnapshotVersion = 0;
+	if(!ReadHeader(SnapshotReader, EFactSaveType::Snapshot, SnapshotVersion))
+	{
+		return false;
+	}
+
+	FGuid SnapshotGuid;
+	SnapshotReader << SnapshotGuid;
+
+	TArray<FFactJournalEntry> LoadedFacts;
+	const uint32 FactCount = ReadCount(SnapshotReader);
+	LoadedFacts.Reserve(FactCount);
+	for(uint32 CurrentFact = 0; CurrentFact < FactCount && !SnapshotReader.IsError(); CurrentFact++)
+	{
+		FFactJournalEntry& Fact = LoadedFacts.AddDefaulted_GetRef();
+		Fact.Slot = FactTable.FindOrAddSlot(ReadTag(SnapshotReader));
+		Fact.bSet = true;
+		Fact.Value = ReadFactValue(SnapshotReader, FactTable, SnapshotVersion, Fact.Type);
+	}
+
+	TArray<FFactJournalEntry> DeltaEntries;
+	if(!Delta.IsEmpty())
+	{
+		FMemoryReader DeltaReader(Delta, true);
+		uint16 DeltaVersion = 0;
+		if(!ReadHeader(DeltaReader, EFactSaveType::Delta, DeltaVersion))
+		{
+			return false;
+		}
+
+		FGuid BaseGuid;
+		DeltaReader << BaseGuid;
+		if(BaseGuid != SnapshotGuid)
+		{
+			UE_LOG(TagFactsSaveLog, Warning, TEXT("Fact delta was saved on top of a different snapshot, nothing was loaded"));
+			return false;
+		}
+
+		const uint32 ChangeCount = ReadCount(DeltaReader);
+		DeltaEntries.Reserve(ChangeCount);
+		for(uint32 CurrentChange = 0; CurrentChange < ChangeCount && !DeltaReader.IsError(); CurrentChange++)
+		{
+			FFactJournalEntry& Entry = DeltaEntries.AddDefaulted_GetRef();
+			Entry.Slot = FactTable.FindOrAddSlot(ReadTag(DeltaReader));
+			uint8 bSet = 0;
+			DeltaReader << bSet;
+			Entry.bSet = bSet != 0;
+			Entry.Value = ReadFactValue(DeltaReader, FactTable, DeltaVersion, Entry.Type);
+		}
+
+		if(DeltaReader.IsError())
+		{
+			UE_LOG(TagFactsSaveLog, Warning, TEXT("Fact delta save data is corrupt"));
+			return false;
+		}
+	}
+
+	if(SnapshotReader.IsError())
+	{
+		UE_LOG(TagFactsSaveLog, Warning, TEXT("Fact snapshot save data is corrupt"));
+		return false;
+	}
+
+	//Build the loaded state per slot, the delta overrides the snapshot.
+	const int32 NumSlots = FactTable.NumSlots();
+	TBitArray<> NewSet(false, NumSlots);
+	TArray<int32> NewValues;
+	TArray<EFactValueType> NewTypes;
+	NewValues.SetNumZeroed(NumSlots);
+	NewTypes.Init(EFactValueType::Int, NumSlots);
+	for(const TArray<FFactJournalEntry>* Changes : {&LoadedFacts, &DeltaEntries})
+	{
+		for(const FFactJournalEntry& CurrentEntry : *Changes)
+		{
+			if(CurrentEntry.Slot != FFactTable::InvalidSlot)
+			{
+				NewSet[CurrentEntry.Slot] = CurrentEntry.bSet;
+				NewValues[CurrentEntry.Slot] = CurrentEntry.Value;
+				NewTypes[CurrentEntry.Slot] = CurrentEntry.Type;
+			}
+		}
+	}
+
+	//Like SetFacts, loading doesn't call any delegates.
+	TArray<int32> SlotsToRemove;
+	FactTable.ForEachSetSlot([&](int32 Slot)
+	{
+		if(!NewSet[Slot])
+		{
+			SlotsToRemove.Add(Slot);
+		}
+	});
+	for(const int32 Slot : SlotsToRemove)
+	{
+		WriteFact(Slot, false, 0);
+	}
+	for(TConstSetBitIterator<> It(NewSet); It; ++It)
+	{
+		WriteFact(It.GetIndex(), true, NewValues[It.GetIndex()], NewTypes[It.GetIndex()]);
+	}
+
+	//The next delta has to contain the loaded one, it replaces it in the save.
+	DeltaEntries.RemoveAll([](const FFactJournalEntry& Entry) { return Entry.Slot == FFactTable::InvalidSlot; });
+	Journal.Restore(SnapshotGuid, MoveTemp(DeltaEntries));
+	return true;
+}
+
+void UFactSubSystem::WriteTypedFacts(TArray<uint8>& OutData) const
+{
+	using namespace FactSaveData;
+
+	OutData.Reset();
+	TArray<int32> TypedSlots;
+	FactTable.ForEachSetSlot([&](int32 Slot)
+	{
+		if(FactTable.GetValueType(Slot) != EFactValueType::Int)
+		{
+			TypedSlots.Add(Slot);
+		}
+	});
+
+	//Most games only use Int facts, keep their saves as they were.
+	if(TypedSlots.IsEmpty())
+	{
+		return;
+	}
+
+	FMemoryWriter Writer(OutData, true);
+	WriteHeader(Writer, EFactSaveType::TypedFacts);
+	WritePacked(Writer, TypedSlots.Num());
+	for(const int32 Slot : TypedSlots)
+	{
+		FString TagName = FactTable.GetTag(Slot).ToString();
+		Writer << TagName;
+		WriteFactValue(Writer, FactTable, FactTable.GetValueType(Slot), FactTable.GetRawValue(Slot));
+	}
+}
+
+void UFactSubSystem::ReadTypedFacts(const TArray<uint8>& Data)
+{
+	using namespace FactSaveData;
+
+	if(Data.IsEmpty())
+	{
+		return;
+	}
+
+	FMemoryReader Reader(Data, true);
+	uint16 Version = 0;
+	if(!ReadHeader(Reader, EFactSaveType::TypedFacts, Version))
+	{
+		return;
+	}
+
+	const uint32 FactCount = ReadCount(Reader);
+	for(uint32 CurrentFact = 0; CurrentFact < FactCount && !Reader.IsError(); CurrentFact++)
+	{
+		const int32 Slot = FactTable.FindOrAddSlot(ReadTag(Reader));
+		EFactValueType Type;
+		const int32 Value = ReadFactValue(Reader, FactTable, Version, Type);
+		if(Slot != FFactTable::InvalidSlot && !Reader.IsError())
+		{
+			WriteFact(Slot, true, Value, Type);
+		}
+	}
+}
+
+bool UFactSubSystem::ShouldSaveFactSnapshot() const
+{
+	return Journal.GetEntries().Num() > CVarJournalSnapshotThreshold.GetValueOnGameThread();
+}
+
+bool UFactSubSystem::SaveFactTimeline(TArray<uint8>& OutData) const
+{
+	using namespace FactSaveData;
+
+	if(!Journal.IsRecordingTimeline())
+	{
+		return false;
+	}
+
+	OutData.Reset();
+	FMemoryWriter Writer(OutData, true);
+	WriteHeader(Writer, EFactSaveType::Timeline);
+
+	//The timeline repeats the same facts a lot, so it refers to them through a name table.
+	const TArray<FFactJournalEntry>& Timeline = Journal.GetTimeline();
+	TArray<int32> SlotToTableIndex;
+	SlotToTableIndex.Init(INDEX_NONE, FactTable.NumSlots());
+	TArray<int32> TableSlots;
+	for(const FFactJournalEntry& Entry : Timeline)
+	{
+		if(SlotToTableIndex[Entry.Slot] == INDEX_NONE)
+		{
+			SlotToTableIndex[Entry.Slot] = TableSlots.Add(Entry.Slot);
+		}
+	}
+
+	WritePacked(Writer, TableSlots.Num());
+	for(const int32 Slot : TableSlots)
+	{
+		FString TagName = FactTable.GetTag(Slot).ToString();
+		Writer << TagName;
+	}
+
+	WritePacked(Writer, Timeline.Num());
+	for(const FFactJournalEntry& Entry : Timeline)
+	{
+		uint8 bSet = Entry.bSet;
+		float Time = Entry.Time;
+		WritePacked(Writer, SlotToTableIndex[Entry.Slot]);
+		Writer << bSet;
+		WriteFactValue(Writer, FactTable, Entry.Type, Entry.Value);
+		Writer << Time;
+	}
+
+	return !Writer.IsError();
+}
+
+bool UFactSubSystem::ReplayFactTimeline(const TArray<uint8>& Data, float UpToTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ReplayFactTimeline)
+	using namespace FactSaveData;
+
+	//Same as LoadFactSave, the replay starts from an empty set of facts the transaction can't undo.
+	if(Transaction.IsActive())
+	{
+		UE_LOG(TagFactsSaveLog, Warning, TEXT("Can't replay a fact timeline during a fact transaction, commit or abort it first"));
+		return false;
+	}
+
+	FMemoryReader Reader(Data, true);
+	uint16 Version = 0;
+	if(!ReadHeader(Reader, EFactSaveType::Timeline, Version))
+	{
+		return false;
+	}
+
+	const uint32 TableSize = ReadCount(Reader);
+	TArray<int32> TableToSlot;
+	TableToSlot.Reserve(TableSize);
+	for(uint32 CurrentTag = 0; CurrentTag < TableSize && !Reader.IsError(); CurrentTag++)
+	{
+		TableToSlot.Add(FactTable.FindOrAddSlot(ReadTag(Reader)));
+	}
+
+	const uint32 EntryCount = ReadCount(Reader);
+	TArray<FFactJournalEntry> Entries;
+	Entries.Reserve(EntryCount);
+	for(uint32 CurrentEntry = 0; CurrentEntry < EntryCount && !Reader.IsError(); CurrentEntry++)
+	{
+		FFactJournalEntry& Entry = Entries.AddDefaulted_GetRef();
+		const uint32 TableIndex = ReadPacked(Reader);
+		uint8 bSet = 0;
+		Reader << bSet;
+		Entry.Slot = TableToSlot.IsValidIndex(TableIndex) ? TableToSlot[TableIndex] : FFactTable::InvalidSlot;
+		Entry.bSet = bSet != 0;
+		Entry.Value = ReadFactValue(Reader, FactTable, Version, Entry.Type);
+		Reader << Entry.Time;
+	}
+
+	if(Reader.IsError())
+	{
+		UE_LOG(TagFactsSaveLog, Warning, TEXT("Fact timeline is corrupt"));
+		return false;
+	}
+
+	//Sessions start without facts, so does the replay.
+	SetFacts({});
+
+	//Apply every change in the order it happened, through the same path as the
+	//original change so listeners react to it the way they did in the session.
+	for(const FFactJournalEntry& Entry : Entries)
+	{
+		if(UpToTime >= 0 && Entry.Time > UpToTime)
+		{
+			break;
+		}
+		if(Entry.Slot == FFactTable::InvalidSlot)
+		{
+			continue;
+		}
+
+		const bool bWasSet = FactTable.IsSet(Entry.Slot);
+		const EFactValueType OldType = FactTable.GetValueType(Entry.Slot);
+		const int32 OldRawValue = FactTable.GetRawValue(Entry.Slot);
+		const int32 OldValue = FactTable.GetValue(Entry.Slot);
+		WriteFact(Entry.Slot, Entry.bSet, Entry.Value, Entry.Type);
+		if(bWasSet != Entry.bSet || OldType != Entry.Type || OldRawValue != Entry.Value)
+		{
+			BroadcastFactChange(Entry.Slot, OldValue,
+				!bWasSet ? EFactChange::Added
+				: !Entry.bSet ? EFactChange::Removed
+				: OldType != EFactValueType::Int || Entry.Type != EFactValueType::Int ? EFactChange::Overridden
+				: Entry.Value > OldValue ? EFactChange::Incremented : EFactChange::Decremented);
+		}
+	}
+
+	return true;
+}
+
+void FFactJournal::ExportTimelineConsoleCommand(const TArray<FString>& Args)
+{
+	const UFactSubSystem* FactSubSystem = UFactSubSystem::Get();
+	if(!FactSubSystem)
+	{
+		return;
+	}
+
+	TArray<uint8> Data;
+	if(!FactSubSystem->SaveFactTimeline(Data))
+	{
+		UE_LOG(TagFactsSaveLog, Warning, TEXT("No fact timeline was recorded, start the game with TagFacts.Journal.RecordTimeline=1"));
+		return;
+	}
+
+	const FString FilePath = FPaths::ProjectSavedDir() / TEXT("TagFacts") / FPaths::GetCleanFilename(Args.IsValidIndex(0) ? Args[0] : TEXT("Timeline.facts"));
+	if(FFileHelper::SaveArrayToFile(Data, *FilePath))
+	{
+		UE_LOG(TagFactsSaveLog, Display, TEXT("Wrote %d fact changes to %s"), FactSubSystem->GetFactJournal().GetTimeline().Num(), *FilePath);
+	}
+	else
+	{
+		UE_LOG(TagFactsSaveLog, Warning, TEXT("Failed to write the fact timeline to %s"), *FilePath);
+	}
+}
+
+void FFactJournal::ReplayTimelineConsoleCommand(const TArray<FString>& Args)
+{
+	UFactSubSystem* FactSubSystem = UFactSubSystem::Get();
+	if(!FactSubSystem)
+	{
+		return;
+	}
+
+	const FString FilePath = FPaths::ProjectSavedDir() / TEXT("TagFacts") / FPaths::GetCleanFilename(Args.IsValidIndex(0) ? Args[0] : TEXT("Timeline.facts"));
+	const float UpToTime = Args.IsValidIndex(1) ? FCString::Atof(*Args[1]) : -1;
+
+	TArray<uint8> Data;
+	if(!FFileHelper::LoadFileToArray(Data, *FilePath) || !FactSubSystem->ReplayFactTimeline(Data, UpToTime))
+	{
+		UE_LOG(TagFactsSaveLog, Warning, TEXT("Failed to replay the fact timeline from %s"), *FilePath);
+		return;
+	}
+
+	UE_LOG(TagFactsSaveLog, Display, TEXT("Replayed the fact timeline from %s, %d facts exist now"), *FilePath, FactSubSystem->GetFactTable().Num());
+}
@@ -3,6 +3,9 @@
 
 #include "..\..\Public\Core\FactSubSystem.h"
 
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
 
 bool UFactSubSystem::ShouldCreateSubsystem(UObject* Outer) const
@@ -10,41 +13,119 @@ bool UFactSubSystem::ShouldCreateSubsystem(UObject* Outer) const
 	return true;
 }
 
-TSet<FS_Fact> UFactSubSystem::GetFacts()
+static TAutoConsoleVariable<bool> CVarJournalRecordTimeline(
+	TEXT("TagFacts.Journal.RecordTimeline"),
+	false,
+	TEXT("Keep every fact change of the session, so it can be exported with TagFacts.Journal.ExportTimeline and replayed. Read when the game instance starts."),
+	ECVF_Default);
+
+void UFactSubSystem::Initialize(FSubsystemCollectionBase& Collection)
 {
-	return Facts;
+	Super::Initialize(Collection);
+
+	Journal.Start(CVarJournalRecordTimeline.GetValueOnGameThread());
+}
+
+void UFactSubSystem::Serialize(FArchive& Ar)
+{
+	//Mirror the table into the Facts property, so save games keep their existing layout.
+	const bool bSaveGame = Ar.IsSaveGame();
+	if(bSaveGame && Ar.IsSaving())
+	{
+		Facts = GetFacts();
+		WriteTypedFacts(TypedFacts);
+	}
+
+	Super::Serialize(Ar);
+
+	if(bSaveGame)
+	{
+		if(Ar.IsLoading())
+		{
+			SetFacts(Facts);
+			ReadTypedFacts(TypedFacts);
+		}
+		Facts.Empty();
+		TypedFacts.Empty();
+	}
+}
+
+UFactSubSystem* UFactSubSystem::Get()
+{
+	if(!GEngine || !GEngine->GameViewport) { return nullptr; }
+	const UWorld* World = GEngine->GameViewport->GetWorld();
+	if(!World) { return nullptr; }
+	const UGameInstance* GameInstance = UGameplayStatics::GetGameInstance(World);
+	return GameInstance ? GameInstance->GetSubsystem<UFactSubSystem>() : nullptr;
+}
+
+TSet<FS_Fact> UFactSubSystem::GetFacts() const
+{
+	TSet<FS_Fact> AllFacts;
+	AllFacts.Reserve(FactTable.Num());
+	FactTable.ForEachSetSlot([&](int32 Slot)
+	{
+		if(FactTable.GetValueType(Slot) == EFactValueType::Int)
+		{
+			AllFacts.Add(FS_Fact({FactTable.GetTag(Slot), FactTable.GetValue(Slot)}));
+		}
+	});
+	return AllFacts;
 }
 
 void UFactSubSystem::SetFacts(TSet<FS_Fact> NewFacts)
 {
-	Facts = NewFacts;
+	//Go through WriteFact so transactions and the journal see the replacement.
+	TArray<int32> SlotsToRemove;
+	FactTable.ForEachSetSlot([&](int32 Slot)
+	{
+		if(!NewFacts.Contains(FS_Fact({FactTable.GetTag(Slot)})))
+		{
+			SlotsToRemove.Add(Slot);
+		}
+	});
+	for(const int32 Slot : SlotsToRemove)
+	{
+		WriteFact(Slot, false, 0);
+	}
+	for(const FS_Fact& CurrentFact : NewFacts)
+	{
+		const int32 Slot = FactTable.FindOrAddSlot(CurrentFact.Tag);
+		if(Slot != FFactTable::InvalidSlot && (!FactTable.IsSet(Slot) || FactTable.GetValueType(Slot) != EFactValueType::Int
+			|| FactTable.GetValue(Slot) != CurrentFact.Value))
+		{
+			WriteFact(Slot, true, CurrentFact.Value);
+		}
+	}
 }
 
 bool UFactSubSystem::AddFact(FS_Fact Fact)
 {
-	if(!Facts.Contains(Fact))
+	const int32 Slot = FactTable.FindOrAddSlot(Fact.Tag);
+	if(Slot == FFactTable::InvalidSlot || FactTable.IsSet(Slot))
 	{
-		Facts.Add(Fact);
-		FactAdded.Broadcast(Fact);
-		
-		return true;
+		return false;
 	}
 
-	return false;
+	WriteFact(Slot, true, Fact.Value);
+	BroadcastFactChange(Slot, 0, EFactChange::Added);
+	
+	return true;
 }
 
 bool UFactSubSystem::RemoveFact(FGameplayTag Fact)
 {
-	if(!Facts.IsEmpty())
+	const int32 Slot = FactTable.FindSlot(Fact);
+	if(!FactTable.IsSet(Slot))
 	{
-		const FS_Fact* FoundFact = Facts.Find(FS_Fact({Fact}));
-		Facts.Remove(FS_Fact({Fact}));
-		FactRemoved.Broadcast(FS_Fact({FoundFact->Tag, FoundFact->Value}));
-		
-		return true;
+		return false;
 	}
 
-	return false;
+	const int32 OldValue = FactTable.GetValue(Slot);
+	WriteFact(Slot, false, 0);
+	BroadcastFactChange(Slot, OldValue, EFactChange::Removed);
+	
+	return true;
 }
 
 void UFactSubSystem::IncrementFact(const FGameplayTag Fact, const int32 Amount)
@@ -53,15 +134,14 @@ void UFactSubSystem::IncrementFact(const FGameplayTag Fact, const int32 Amount)
 	{
 		return;
 	}
-	
-	if(!Facts.IsEmpty())
+
+	//Only Int facts can be counted, other types are left alone.
+	const int32 Slot = FactTable.FindSlot(Fact);
+	if(FactTable.IsSet(Slot) && FactTable.GetValueType(Slot) == EFactValueType::Int)
 	{
-		if(FS_Fact* FoundFact = Facts.Find(FS_Fact({Fact})))
-		{
-			const int32 OldValue = FoundFact->Value;
-			FoundFact->Value = FoundFact->Value + Amount;
-			FactIncremented.Broadcast(FS_Fact({FoundFact->Tag, FoundFact->Value}), OldValue);
-		}
+		const int32 OldValue = FactTable.GetValue(Slot);
+		WriteFact(Slot, true, OldValue + Amount);
+		BroadcastFactChange(Slot, OldValue, EFactChange::Incremented);
 	}
 }
 
@@ -71,49 +151,510 @@ void UFactSubSystem::DecrementFact(const FGameplayTag Fact, const int32 Amount)
 	{
 		return;
 	}
+
+	//Only Int facts can be counted, other types are left alone.
+	const int32 Slot = FactTable.FindSlot(Fact);
+	if(FactTable.IsSet(Slot) && FactTable.GetValueType(Slot) == EFactValueType::Int)
+	{
+		const int32 OldValue = FactTable.GetValue(Slot);
+		WriteFact(Slot, true, OldValue - Amount);
+		BroadcastFactChange(Slot, OldValue, EFactChange::Decremented);
+	}
+}
+
+bool UFactSubSystem::OverrideFactValue(FS_Fact Fact)
+{
+	const int32 Slot = FactTable.FindSlot(Fact.Tag);
+	if(FactTable.IsSet(Slot))
+	{
+		const int32 OldValue = FactTable.GetValue(Slot);
+		WriteFact(Slot, true, Fact.Value);
+		BroadcastFactChange(Slot, OldValue, EFactChange::Overridden);
+	}
+
+	return false;
+}
+
+bool UFactSubSystem::DoesFactExist(FGameplayTag Fact) const
+{
+	if(!IsInGameThread())
+	{
+		int32 Value;
+		return FactTable.ReadFact_AnyThread(Fact, Value);
+	}
+	
+	return FactTable.IsSet(FactTable.FindSlot(Fact));
+}
+
+int32 UFactSubSystem::GetFactValue(FGameplayTag Fact) const
+{
+	if(!IsInGameThread())
+	{
+		int32 Value;
+		FactTable.ReadFact_AnyThread(Fact, Value);
+		return Value;
+	}
 	
-	if(!Facts.IsEmpty())
+	return FactTable.GetValue(FactTable.FindSlot(Fact));
+}
+
+EFactValueType UFactSubSystem::GetFactValueType(FGameplayTag Fact) const
+{
+	return FactTable.GetValueType(FactTable.FindSlot(Fact));
+}
+
+bool UFactSubSystem::SetFactFloat(FGameplayTag Fact, float Value)
+{
+	return WriteTypedFact(Fact, EFactValueType::Float, FFactTable::FloatToRaw(Value));
+}
+
+float UFactSubSystem::GetFactFloat(FGameplayTag Fact) const
+{
+	return FactTable.GetFloatValue(FactTable.FindSlot(Fact));
+}
+
+bool UFactSubSystem::SetFactBool(FGameplayTag Fact, bool Value)
+{
+	return WriteTypedFact(Fact, EFactValueType::Bool, Value);
+}
+
+bool UFactSubSystem::GetFactBool(FGameplayTag Fact) const
+{
+	return FactTable.GetBoolValue(FactTable.FindSlot(Fact));
+}
+
+bool UFactSubSystem::SetFactTag(FGameplayTag Fact, FGameplayTag Value)
+{
+	return WriteTypedFact(Fact, EFactValueType::Tag, FactTable.FindOrAddSlot(Value));
+}
+
+FGameplayTag UFactSubSystem::GetFactTag(FGameplayTag Fact) const
+{
+	return FactTable.GetTagValue(FactTable.FindSlot(Fact));
+}
+
+bool UFactSubSystem::SetFactBitfield(FGameplayTag Fact, int32 Bits)
+{
+	return WriteTypedFact(Fact, EFactValueType::Bitfield, Bits);
+}
+
+int32 UFactSubSystem::GetFactBitfield(FGameplayTag Fact) const
+{
+	return static_cast<int32>(FactTable.GetBitfieldValue(FactTable.FindSlot(Fact)));
+}
+
+bool UFactSubSystem::SetFactFlag(FGameplayTag Fact, int32 Bit, bool Enabled)
+{
+	if(Bit < 0 || Bit > 31)
+	{
+		return false;
+	}
+
+	uint32 Bits = FactTable.GetBitfieldValue(FactTable.FindSlot(Fact));
+	Bits = Enabled ? Bits | (1u << Bit) : Bits & ~(1u << Bit);
+	return WriteTypedFact(Fact, EFactValueType::Bitfield, static_cast<int32>(Bits));
+}
+
+bool UFactSubSystem::HasFactFlag(FGameplayTag Fact, int32 Bit) const
+{
+	return Bit >= 0 && Bit <= 31 && (FactTable.GetBitfieldValue(FactTable.FindSlot(Fact)) & (1u << Bit)) != 0;
+}
+
+bool UFactSubSystem::WriteTypedFact(FGameplayTag Fact, EFactValueType Type, int32 RawValue)
+{
+	const int32 Slot = FactTable.FindOrAddSlot(Fact);
+	if(Slot == FFactTable::InvalidSlot)
+	{
+		return false;
+	}
+
+	const bool bWasSet = FactTable.IsSet(Slot);
+	if(bWasSet && FactTable.GetValueType(Slot) == Type && FactTable.GetRawValue(Slot) == RawValue)
+	{
+		return false;
+	}
+
+	const int32 OldValue = FactTable.GetValue(Slot);
+	WriteFact(Slot, true, RawValue, Type);
+	BroadcastFactChange(Slot, OldValue, bWasSet ? EFactChange::Overridden : EFactChange::Added);
+	return true;
+}
+
+int64 UFactSubSystem::GetFactSum(FGameplayTag Parent) const
+{
+	return FactTable.GetSubtreeSum(FactTable.FindSlot(Parent));
+}
+
+int32 UFactSubSystem::GetFactCount(FGameplayTag Parent) const
+{
+	return FactTable.GetSubtreeCount(FactTable.FindSlot(Parent));
+}
+
+int32 UFactSubSystem::GetFactMax(FGameplayTag Parent) const
+{
+	return FactTable.GetSubtreeMax(FactTable.FindSlot(Parent));
+}
+
+void UFactSubSystem::BeginFactTransaction()
+{
+	//Every level remembers where it began, so aborting it only undoes its own changes.
+	FFactSavepoint& Savepoint = Transaction.Savepoints.AddDefaulted_GetRef();
+	Savepoint.JournalStart = Journal.GetEntries().Num();
+	Savepoint.TimelineStart = Journal.GetTimeline().Num();
+	Savepoint.UndoStart = Transaction.UndoLog.Num();
+	Journal.SetSavepoint(Savepoint.JournalStart);
+
+	//Facts an outer level already logged are logged again, with the value they have now.
+	Transaction.LoggedSlots.Init(false, Transaction.LoggedSlots.Num());
+}
+
+bool UFactSubSystem::CommitFactTransaction()
+{
+	if(!Transaction.IsActive())
+	{
+		return false;
+	}
+
+	if(Transaction.Savepoints.Num() > 1)
 	{
-		if(FS_Fact* FoundFact = Facts.Find(FS_Fact({Fact})))
+		//The changes now belong to the outer level, aborting that still undoes them.
+		Transaction.Savepoints.Pop(EAllowShrinking::No);
+		Journal.SetSavepoint(Transaction.Savepoints.Last().JournalStart);
+		Transaction.RebuildLoggedSlots();
+		return true;
+	}
+
+	//Swap the log out first, listeners are free to change facts or start a new transaction.
+	TArray<FFactUndoEntry> UndoLog = MoveTemp(Transaction.UndoLog);
+	Transaction.Reset();
+	Journal.SetSavepoint(0);
+
+	//Only the net change of every fact is sent, intermediate values are never seen by listeners.
+	TArray<FFactChangeEntry> Changes;
+	TArray<int32> ChangedSlots;
+	TArray<bool> IntChanges;
+	Changes.Reserve(UndoLog.Num());
+	ChangedSlots.Reserve(UndoLog.Num());
+	IntChanges.Reserve(UndoLog.Num());
+	TBitArray<> SeenSlots(false, FactTable.NumSlots());
+	for(const FFactUndoEntry& CurrentEntry : UndoLog)
+	{
+		//Nested transactions can log a fact again, the first entry has its value from before all of them.
+		if(SeenSlots[CurrentEntry.Slot])
 		{
-			const int32 OldValue = FoundFact->Value;
-			FoundFact->Value = FoundFact->Value - Amount;
-			FactDecremented.Broadcast(FS_Fact({FoundFact->Tag, FoundFact->Value}), OldValue);
+			continue;
 		}
+		SeenSlots[CurrentEntry.Slot] = true;
+
+		const bool bIsSet = FactTable.IsSet(CurrentEntry.Slot);
+		const EFactValueType NewType = FactTable.GetValueType(CurrentEntry.Slot);
+		if(bIsSet == CurrentEntry.bWasSet && NewType == CurrentEntry.OldType && FactTable.GetRawValue(CurrentEntry.Slot) == CurrentEntry.OldValue)
+		{
+			continue;
+		}
+
+		ChangedSlots.Add(CurrentEntry.Slot);
+		IntChanges.Add(NewType == EFactValueType::Int && CurrentEntry.OldType == EFactValueType::Int);
+		FFactChangeEntry& Change = Changes.AddDefaulted_GetRef();
+		Change.Tag = FactTable.GetTag(CurrentEntry.Slot);
+		Change.OldValue = CurrentEntry.OldType == EFactValueType::Int ? CurrentEntry.OldValue : 0;
+		Change.NewValue = FactTable.GetValue(CurrentEntry.Slot);
+		Change.Existed = CurrentEntry.bWasSet;
+		Change.Exists = bIsSet;
 	}
+
+	for(int32 CurrentChange = 0; CurrentChange < Changes.Num(); CurrentChange++)
+	{
+		const FFactChangeEntry& Change = Changes[CurrentChange];
+		const EFactChange ChangeType = !Change.Existed ? EFactChange::Added
+			: !Change.Exists ? EFactChange::Removed
+			: !IntChanges[CurrentChange] ? EFactChange::Overridden
+			: Change.NewValue > Change.OldValue ? EFactChange::Incremented : EFactChange::Decremented;
+		BroadcastFactChange(ChangedSlots[CurrentChange], Change.OldValue, ChangeType);
+	}
+
+	if(!Changes.IsEmpty())
+	{
+		FactTransactionCommitted.Broadcast(Changes);
+	}
+	
+	return true;
 }
 
-bool UFactSubSystem::OverrideFactValue(FS_Fact Fact)
+bool UFactSubSystem::AbortFactTransaction()
+{
+	if(!Transaction.IsActive())
+	{
+		return false;
+	}
+
+	//Nothing that happened in the transaction should end up in a save or replay.
+	const FFactSavepoint Savepoint = Transaction.Savepoints.Pop(EAllowShrinking::No);
+	Journal.Truncate(Savepoint.JournalStart, Savepoint.TimelineStart);
+
+	//Newest first, so a fact that nested transactions logged more than once ends up at its oldest value.
+	for(int32 CurrentEntry = Transaction.UndoLog.Num() - 1; CurrentEntry >= Savepoint.UndoStart; CurrentEntry--)
+	{
+		const FFactUndoEntry& Entry = Transaction.UndoLog[CurrentEntry];
+		if(Entry.bWasSet)
+		{
+			FactTable.SetRawValue(Entry.Slot, Entry.OldType, Entry.OldValue);
+		}
+		else
+		{
+			FactTable.Unset(Entry.Slot);
+		}
+	}
+	Transaction.UndoLog.SetNum(Savepoint.UndoStart, EAllowShrinking::No);
+
+	if(Transaction.IsActive())
+	{
+		Journal.SetSavepoint(Transaction.Savepoints.Last().JournalStart);
+		Transaction.RebuildLoggedSlots();
+	}
+	else
+	{
+		Transaction.Reset();
+		Journal.SetSavepoint(0);
+	}
+	return true;
+}
+
+void UFactSubSystem::WriteFact(int32 Slot, bool bSet, int32 Value, EFactValueType Type)
+{
+	if(Transaction.IsActive())
+	{
+		//Only the value from before the transaction matters, later writes are overwritten by it on abort.
+		if(!Transaction.LoggedSlots.IsValidIndex(Slot))
+		{
+			Transaction.LoggedSlots.SetNum(FactTable.NumSlots(), false);
+		}
+		if(!Transaction.LoggedSlots[Slot])
+		{
+			Transaction.LoggedSlots[Slot] = true;
+			Transaction.UndoLog.Add({Slot, FactTable.GetRawValue(Slot), FactTable.GetValueType(Slot), FactTable.IsSet(Slot)});
+		}
+	}
+
+	if(bSet)
+	{
+		FactTable.SetRawValue(Slot, Type, Value);
+	}
+	else
+	{
+		FactTable.Unset(Slot);
+	}
+	Journal.Append(Slot, bSet, Value, Type);
+}
+
+void UFactSubSystem::BroadcastFactChange(int32 Slot, int32 OldValue, EFactChange Change)
+{
+	//Transactions send everything at once when they are committed.
+	if(Transaction.IsActive())
+	{
+		return;
+	}
+
+	const FS_Fact Fact({FactTable.GetTag(Slot), FactTable.GetValue(Slot)});
+	switch(Change)
+	{
+	case EFactChange::Added:
+		FactAdded.Broadcast(Fact);
+		break;
+	case EFactChange::Removed:
+		FactRemoved.Broadcast(FS_Fact({Fact.Tag, OldValue}));
+		break;
+	case EFactChange::Incremented:
+		FactIncremented.Broadcast(Fact, OldValue);
+		break;
+	case EFactChange::Decremented:
+		FactDecremented.Broadcast(Fact, OldValue);
+		break;
+	case EFactChange::Overridden:
+		FactOverriden.Broadcast(OldValue, Fact.Value);
+		break;
+	}
+
+	NotifyFactChanged(Slot, OldValue, Change);
+}
+
+bool UFactSubSystem::EvaluateFactExpression(const FFactExpression& Expression)
+{
+	return Expression.Evaluate(*this);
+}
+
+FDelegateHandle UFactSubSystem::SubscribeToFact(FGameplayTag Fact, FOnFactChanged Delegate)
 {
-	if(!Facts.IsEmpty())
+	FFactSubscription Subscription;
+	Subscription.Delegate = MoveTemp(Delegate);
+	return AddSubscription(Fact, false, MoveTemp(Subscription));
+}
+
+FDelegateHandle UFactSubSystem::SubscribeToFactPrefix(FGameplayTag Parent, FOnFactChanged Delegate)
+{
+	FFactSubscription Subscription;
+	Subscription.Delegate = MoveTemp(Delegate);
+	return AddSubscription(Parent, true, MoveTemp(Subscription));
+}
+
+bool UFactSubSystem::UnsubscribeFromFact(FGameplayTag Fact, FDelegateHandle Handle)
+{
+	const int32 Slot = FactTable.FindSlot(Fact);
+	if(Slot == FFactTable::InvalidSlot || !Handle.IsValid())
+	{
+		return false;
+	}
+
+	for(TMap<int32, TArray<FFactSubscription>>* Subscriptions : {&FactSubscriptions, &PrefixSubscriptions})
 	{
-		if(FS_Fact* FoundFact = Facts.Find(FS_Fact({Fact})))
+		if(RemoveSubscriptions(*Subscriptions, Slot, [&Handle](const FFactSubscription& Subscription) { return Subscription.Handle == Handle; }))
 		{
-			const int32 OldValue = FoundFact->Value;
-			const int32 NewValue = Fact.Value;
-			FoundFact->Value = Fact.Value;
-			FactOverriden.Broadcast(OldValue, NewValue);
+			return true;
 		}
 	}
 
 	return false;
 }
 
-bool UFactSubSystem::DoesFactExist(FGameplayTag Fact)
+void UFactSubSystem::BindToFact(FGameplayTag Fact, bool IncludeChildren, FFactChanged Delegate)
 {
-	return Facts.Contains(FS_Fact({Fact}));
+	if(!Delegate.IsBound())
+	{
+		return;
+	}
+
+	FFactSubscription Subscription;
+	Subscription.DynamicDelegate = MoveTemp(Delegate);
+	AddSubscription(Fact, IncludeChildren, MoveTemp(Subscription));
 }
 
-int32 UFactSubSystem::GetFactValue(FGameplayTag Fact)
+void UFactSubSystem::UnbindFromFact(FGameplayTag Fact, FFactChanged Delegate)
 {
-	if(!Facts.IsEmpty())
+	const int32 Slot = FactTable.FindSlot(Fact);
+	if(Slot == FFactTable::InvalidSlot)
+	{
+		return;
+	}
+
+	for(TMap<int32, TArray<FFactSubscription>>* Subscriptions : {&FactSubscriptions, &PrefixSubscriptions})
+	{
+		RemoveSubscriptions(*Subscriptions, Slot, [&Delegate](const FFactSubscription& Subscription) { return Subscription.DynamicDelegate == Delegate; });
+	}
+}
+
+FDelegateHandle UFactSubSystem::AddSubscription(FGameplayTag Fact, bool bIncludeChildren, FFactSubscription&& Subscription)
+{
+	//Subscribing reserves the slot, so the fact can be subscribed to before it exists.
+	const int32 Slot = FactTable.FindOrAddSlot(Fact);
+	if(Slot == FFactTable::InvalidSlot)
+	{
+		return FDelegateHandle();
+	}
+
+	Subscription.Handle = FDelegateHandle(FDelegateHandle::GenerateNewHandle);
+	const FDelegateHandle Handle = Subscription.Handle;
+	(bIncludeChildren ? PrefixSubscriptions : FactSubscriptions).FindOrAdd(Slot).Add(MoveTemp(Subscription));
+	return Handle;
+}
+
+void UFactSubSystem::NotifyFactChanged(int32 Slot, int32 OldValue, EFactChange Change)
+{
+	if(FactSubscriptions.IsEmpty() && PrefixSubscriptions.IsEmpty())
+	{
+		return;
+	}
+
+	//Gather first, a subscriber is allowed to subscribe, unsubscribe or change other facts
+	//while being notified. Only where to find each subscription is kept, not the delegates,
+	//and removals are held back until the outermost notify is done so those stay valid.
+	struct FGatheredSubscriptions
+	{
+		TMap<int32, TArray<FFactSubscription>>* Subscriptions;
+		int32 Slot;
+		int32 Num;
+	};
+	TArray<FGatheredSubscriptions, TInlineAllocator<8>> Gathered;
+	if(const TArray<FFactSubscription>* ExactSubscriptions = FactSubscriptions.Find(Slot))
 	{
-		FS_Fact* FoundFact = Facts.Find(FS_Fact({Fact}));
-		if(FoundFact)
+		Gathered.Add({&FactSubscriptions, Slot, ExactSubscriptions->Num()});
+	}
+
+	if(!PrefixSubscriptions.IsEmpty())
+	{
+		for(int32 CurrentSlot = Slot; CurrentSlot != FFactTable::InvalidSlot; CurrentSlot = FactTable.GetParentSlot(CurrentSlot))
+		{
+			if(const TArray<FFactSubscription>* ParentSubscriptions = PrefixSubscriptions.Find(CurrentSlot))
+			{
+				Gathered.Add({&PrefixSubscriptions, CurrentSlot, ParentSubscriptions->Num()});
+			}
+		}
+	}
+
+	NotifyDepth++;
+	const FS_Fact Fact({FactTable.GetTag(Slot), FactTable.GetValue(Slot)});
+	for(const FGatheredSubscriptions& CurrentGathered : Gathered)
+	{
+		//Subscriptions added while notifying go to the end and are not told about this change.
+		for(int32 CurrentSubscription = 0; CurrentSubscription < CurrentGathered.Num; CurrentSubscription++)
+		{
+			//Looked up again every time, a subscriber adding to this array can reallocate it.
+			const FFactSubscription& Subscription = CurrentGathered.Subscriptions->FindChecked(CurrentGathered.Slot)[CurrentSubscription];
+			if(!Subscription.bRemoved)
+			{
+				Subscription.Notify(Fact, OldValue, Change);
+			}
+		}
+	}
+
+	if(--NotifyDepth == 0 && bHasRemovedSubscriptions)
+	{
+		PurgeRemovedSubscriptions();
+	}
+}
+
+bool UFactSubSystem::RemoveSubscriptions(TMap<int32, TArray<FFactSubscription>>& Subscriptions, int32 Slot, TFunctionRef<bool(const FFactSubscription&)> Predicate)
+{
+	TArray<FFactSubscription>* SlotSubscriptions = Subscriptions.Find(Slot);
+	if(!SlotSubscriptions)
+	{
+		return false;
+	}
+
+	if(NotifyDepth == 0)
+	{
+		const bool bRemovedAny = SlotSubscriptions->RemoveAll([&Predicate](const FFactSubscription& Subscription) { return Predicate(Subscription); }) > 0;
+		if(SlotSubscriptions->IsEmpty())
+		{
+			Subscriptions.Remove(Slot);
+		}
+		return bRemovedAny;
+	}
+
+	bool bRemovedAny = false;
+	for(FFactSubscription& Subscription : *SlotSubscriptions)
+	{
+		if(!Subscription.bRemoved && Predicate(Subscription))
 		{
-			return FoundFact->Value;
+			Subscription.bRemoved = true;
+			bRemovedAny = true;
 		}
 	}
+	bHasRemovedSubscriptions |= bRemovedAny;
+	return bRemovedAny;
+}
 
-	return 0;
+void UFactSubSystem::PurgeRemovedSubscriptions()
+{
+	bHasRemovedSubscriptions = false;
+	for(TMap<int32, TArray<FFactSubscription>>* Subscriptions : {&FactSubscriptions, &PrefixSubscriptions})
+	{
+		for(auto It = Subscriptions->CreateIterator(); It; ++It)
+		{
+			It.Value().RemoveAll([](const FFactSubscription& Subscription) { return Subscription.bRemoved; });
+			if(It.Value().IsEmpty())
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
 }
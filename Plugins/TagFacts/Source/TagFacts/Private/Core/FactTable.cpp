@@ -0,0 +1,266 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/FactTable.h"
+
+int32 FFactTable::FindOrAddSlot(const FGameplayTag& Tag)
+{
+	if(!Tag.IsValid())
+	{
+		return InvalidSlot;
+	}
+
+	if(const int32* FoundSlot = TagToSlot.Find(Tag))
+	{
+		return *FoundSlot;
+	}
+
+	//Give the parent a slot first, this lets prefix lookups walk up the chain by slot.
+	const int32 ParentSlot = FindOrAddSlot(Tag.RequestDirectParent());
+
+	const int32 NewSlot = SlotTags.Add(Tag);
+	ParentSlots.Add(ParentSlot);
+	Values.Add(0);
+	SetSlots.Add(false);
+	SlotTypes.Add(EFactValueType::Int);
+	SlotRevisions.Add(0);
+	ChildSlots.AddDefaulted();
+	SubtreeSums.Add(0);
+	SubtreeCounts.Add(0);
+	SubtreeMaxes.Add(0);
+	StaleMaxes.Add(false);
+	TagToSlot.Add(Tag, NewSlot);
+	ConcurrentView.AddSlot(Tag, NewSlot);
+	if(ParentSlot != InvalidSlot)
+	{
+		ChildSlots[ParentSlot].Add(NewSlot);
+	}
+	return NewSlot;
+}
+
+void FFactTable::SetValue(int32 Slot, int32 Value)
+{
+	if(!SlotTags.IsValidIndex(Slot))
+	{
+		return;
+	}
+
+	const bool bWasSet = SetSlots[Slot];
+	const int32 OldValue = Values[Slot];
+	if(!bWasSet)
+	{
+		SetSlots[Slot] = true;
+		NumSet++;
+	}
+	else if(OldValue == Value && SlotTypes[Slot] == EFactValueType::Int)
+	{
+		return;
+	}
+	
+	SlotTypes[Slot] = EFactValueType::Int;
+	Values[Slot] = Value;
+	ConcurrentView.Write(Slot, true, Value);
+	SlotRevisions[Slot] = ++Revision;
+	UpdateAggregates(Slot, bWasSet, OldValue, true, Value);
+}
+
+int32 FFactTable::GetRawValue(int32 Slot) const
+{
+	switch(GetValueType(Slot))
+	{
+	case EFactValueType::Float:
+		return FloatToRaw(FloatValues[Slot]);
+	case EFactValueType::Bool:
+		return BoolValues[Slot];
+	case EFactValueType::Tag:
+		return TagValues[Slot];
+	case EFactValueType::Bitfield:
+		return static_cast<int32>(BitfieldValues[Slot]);
+	default:
+		return GetValue(Slot);
+	}
+}
+
+void FFactTable::SetRawValue(int32 Slot, EFactValueType Type, int32 RawValue)
+{
+	if(Type == EFactValueType::Int)
+	{
+		SetValue(Slot, RawValue);
+		return;
+	}
+
+	if(!SlotTags.IsValidIndex(Slot))
+	{
+		return;
+	}
+
+	const bool bWasSet = SetSlots[Slot];
+	const int32 OldValue = Values[Slot];
+	if(!bWasSet)
+	{
+		SetSlots[Slot] = true;
+		NumSet++;
+	}
+	else if(SlotTypes[Slot] == Type && GetRawValue(Slot) == RawValue)
+	{
+		return;
+	}
+
+	//Columns only grow when a slot past their end first gets their type.
+	switch(Type)
+	{
+	case EFactValueType::Float:
+		if(Slot >= FloatValues.Num())
+		{
+			FloatValues.SetNumZeroed(Slot + 1);
+		}
+		FloatValues[Slot] = RawToFloat(RawValue);
+		break;
+	case EFactValueType::Bool:
+		if(Slot >= BoolValues.Num())
+		{
+			BoolValues.SetNum(Slot + 1, false);
+		}
+		BoolValues[Slot] = RawValue != 0;
+		break;
+	case EFactValueType::Tag:
+		if(Slot >= TagValues.Num())
+		{
+			TagValues.SetNumZeroed(Slot + 1);
+		}
+		TagValues[Slot] = RawValue;
+		break;
+	case EFactValueType::Bitfield:
+		if(Slot >= BitfieldValues.Num())
+		{
+			BitfieldValues.SetNumZeroed(Slot + 1);
+		}
+		BitfieldValues[Slot] = static_cast<uint32>(RawValue);
+		break;
+	default:
+		break;
+	}
+
+	SlotTypes[Slot] = Type;
+	Values[Slot] = 0;
+	ConcurrentView.Write(Slot, true, 0);
+	SlotRevisions[Slot] = ++Revision;
+	UpdateAggregates(Slot, bWasSet, OldValue, true, 0);
+}
+
+void FFactTable::Unset(int32 Slot)
+{
+	if(!IsSet(Slot))
+	{
+		return;
+	}
+
+	const int32 OldValue = Values[Slot];
+	SetSlots[Slot] = false;
+	SlotTypes[Slot] = EFactValueType::Int;
+	Values[Slot] = 0;
+	ConcurrentView.Write(Slot, false, 0);
+	NumSet--;
+	SlotRevisions[Slot] = ++Revision;
+	UpdateAggregates(Slot, true, OldValue, false, 0);
+}
+
+void FFactTable::Reset()
+{
+	for(TConstSetBitIterator<> It(SetSlots); It; ++It)
+	{
+		ConcurrentView.Write(It.GetIndex(), false, 0);
+	}
+	
+	SetSlots.SetRange(0, SetSlots.Num(), false);
+	FMemory::Memzero(Values.GetData(), Values.Num() * sizeof(int32));
+	FMemory::Memzero(SlotTypes.GetData(), SlotTypes.Num() * sizeof(EFactValueType));
+	FloatValues.Reset();
+	BoolValues.Reset();
+	TagValues.Reset();
+	BitfieldValues.Reset();
+	NumSet = 0;
+
+	++Revision;
+	for(uint32& SlotRevision : SlotRevisions)
+	{
+		SlotRevision = Revision;
+	}
+
+	FMemory::Memzero(SubtreeSums.GetData(), SubtreeSums.Num() * sizeof(int64));
+	FMemory::Memzero(SubtreeCounts.GetData(), SubtreeCounts.Num() * sizeof(int32));
+	FMemory::Memzero(SubtreeMaxes.GetData(), SubtreeMaxes.Num() * sizeof(int32));
+	StaleMaxes.SetRange(0, StaleMaxes.Num(), false);
+}
+
+int32 FFactTable::GetSubtreeMax(int32 Slot) const
+{
+	if(!SubtreeMaxes.IsValidIndex(Slot) || SubtreeCounts[Slot] == 0)
+	{
+		return 0;
+	}
+
+	if(StaleMaxes[Slot])
+	{
+		SubtreeMaxes[Slot] = ComputeSubtreeMax(Slot);
+		StaleMaxes[Slot] = false;
+	}
+
+	return SubtreeMaxes[Slot];
+}
+
+void FFactTable::UpdateAggregates(int32 Slot, bool bWasSet, int32 OldValue, bool bIsSet, int32 NewValue)
+{
+	const int64 SumDelta = static_cast<int64>(bIsSet ? NewValue : 0) - (bWasSet ? OldValue : 0);
+	const int32 CountDelta = static_cast<int32>(bIsSet) - static_cast<int32>(bWasSet);
+
+	for(int32 CurrentSlot = Slot; CurrentSlot != InvalidSlot; CurrentSlot = ParentSlots[CurrentSlot])
+	{
+		SubtreeSums[CurrentSlot] += SumDelta;
+		SubtreeCounts[CurrentSlot] += CountDelta;
+
+		if(SubtreeCounts[CurrentSlot] == 0)
+		{
+			SubtreeMaxes[CurrentSlot] = 0;
+			StaleMaxes[CurrentSlot] = false;
+		}
+		else if(StaleMaxes[CurrentSlot])
+		{
+			//Already being recomputed on the next read.
+		}
+		else if(bIsSet && (NewValue >= SubtreeMaxes[CurrentSlot] || (!bWasSet && SubtreeCounts[CurrentSlot] == 1)))
+		{
+			SubtreeMaxes[CurrentSlot] = NewValue;
+		}
+		else if(bWasSet && OldValue == SubtreeMaxes[CurrentSlot])
+		{
+			//The highest value went down or away, we don't know the new highest without looking.
+			StaleMaxes[CurrentSlot] = true;
+		}
+	}
+}
+
+int32 FFactTable::ComputeSubtreeMax(int32 Slot) const
+{
+	int32 Max = MIN_int32;
+	TArray<int32, TInlineAllocator<32>> SlotsToVisit;
+	SlotsToVisit.Add(Slot);
+	while(!SlotsToVisit.IsEmpty())
+	{
+		const int32 CurrentSlot = SlotsToVisit.Pop(EAllowShrinking::No);
+
+		//Empty branches can be skipped entirely.
+		if(SubtreeCounts[CurrentSlot] == 0)
+		{
+			continue;
+		}
+		
+		if(SetSlots[CurrentSlot])
+		{
+			Max = FMath::Max(Max, Values[CurrentSlot]);
+		}
+		SlotsToVisit.Append(ChildSlots[CurrentSlot]);
+	}
+
+	return Max;
+}
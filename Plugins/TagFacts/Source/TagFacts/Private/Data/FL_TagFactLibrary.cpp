@@ -25,3 +25,9 @@ bool UFL_TagFactLibrary::CompareFact(FS_Fact Fact, int32 Value, TEnumAsByte<EFac
 		return false;
 	}
 }
+
+void UFL_TagFactLibrary::SetFactExpressionChecks(FFactExpression& Expression, const TArray<FFactCheckGroup>& AnyOf)
+{
+	Expression.AnyOf = AnyOf;
+	Expression.Invalidate();
+}
@@ -0,0 +1,138 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Data/FactExpression.h"
+
+#include "Core/FactSubSystem.h"
+
+uint32 FFactExpression::Generation = 0;
+
+bool FFactExpression::Evaluate(UFactSubSystem& FactSubSystem) const
+{
+	if(CompiledFor.Get() != &FactSubSystem || CompiledGeneration != Generation)
+	{
+		Compile(FactSubSystem);
+	}
+
+	if(!Memoize)
+	{
+		return EvaluateCompiled(FactSubSystem);
+	}
+
+	const FFactTable& FactTable = FactSubSystem.GetFactTable();
+	if(bHasResult && EvaluatedRevision != FactTable.GetRevision())
+	{
+		//Something changed, but only evaluate again if it was one of our facts.
+		for(const int32 Slot : ReferencedSlots)
+		{
+			if(FactTable.GetSlotRevision(Slot) > EvaluatedRevision)
+			{
+				bHasResult = false;
+				break;
+			}
+		}
+	}
+
+	if(!bHasResult)
+	{
+		bResult = EvaluateCompiled(FactSubSystem);
+		bHasResult = true;
+	}
+
+	EvaluatedRevision = FactTable.GetRevision();
+	return bResult;
+}
+
+void FFactExpression::Invalidate() const
+{
+	CompiledFor.Reset();
+	CompiledChecks.Reset();
+	GroupEnds.Reset();
+	ReferencedSlots.Reset();
+	bHasResult = false;
+}
+
+void FFactExpression::Compile(UFactSubSystem& FactSubSystem) const
+{
+	Invalidate();
+
+	//Slots are handed out on first use and never change, so facts that don't
+	//exist yet get their slot now and the expression never has to compile again.
+	for(const FFactCheckGroup& CurrentGroup : AnyOf)
+	{
+		for(const FFactCheck& CurrentCheck : CurrentGroup.Checks)
+		{
+			FCompiledFactCheck& CompiledCheck = CompiledChecks.AddDefaulted_GetRef();
+			CompiledCheck.Slot = FactSubSystem.FindOrAddFactSlot(CurrentCheck.Fact.Tag);
+			CompiledCheck.Comparator = CurrentCheck.CheckToPerform;
+			CompiledCheck.bNot = CurrentCheck.Not;
+			CompiledCheck.Value = CurrentCheck.ValueToCompare;
+			CompiledCheck.MaxValue = CurrentCheck.MaxValueToCompare;
+			if(CurrentCheck.Type == EFactType::Fact)
+			{
+				CompiledCheck.OtherSlot = FactSubSystem.FindOrAddFactSlot(CurrentCheck.FactToCompare.Tag);
+				ReferencedSlots.AddUnique(CompiledCheck.OtherSlot);
+			}
+			ReferencedSlots.AddUnique(CompiledCheck.Slot);
+		}
+		GroupEnds.Add(CompiledChecks.Num());
+	}
+
+	CompiledFor = &FactSubSystem;
+	CompiledGeneration = Generation;
+}
+
+bool FFactExpression::EvaluateCompiled(const UFactSubSystem& FactSubSystem) const
+{
+	//No groups means no requirements.
+	if(GroupEnds.IsEmpty())
+	{
+		return true;
+	}
+
+	const FFactTable& FactTable = FactSubSystem.GetFactTable();
+	int32 GroupStart = 0;
+	for(const int32 GroupEnd : GroupEnds)
+	{
+		bool bGroupPassed = true;
+		for(int32 CurrentCheck = GroupStart; CurrentCheck < GroupEnd && bGroupPassed; CurrentCheck++)
+		{
+			const FCompiledFactCheck& Check = CompiledChecks[CurrentCheck];
+			const int32 FactValue = FactTable.GetValue(Check.Slot);
+			const int32 CompareValue = Check.OtherSlot != INDEX_NONE ? FactTable.GetValue(Check.OtherSlot) : Check.Value;
+
+			bool bPassed;
+			switch(Check.Comparator)
+			{
+			case IsTrue:
+				bPassed = FactValue > 0;
+				break;
+			case IsFactGreaterThan:
+				bPassed = FactValue > CompareValue;
+				break;
+			case IsFactLessThan:
+				bPassed = FactValue < CompareValue;
+				break;
+			case IsFactEqualTo:
+				bPassed = FactValue == CompareValue;
+				break;
+			case IsFactInRange:
+				bPassed = FactValue >= CompareValue && FactValue <= Check.MaxValue;
+				break;
+			default:
+				bPassed = false;
+				break;
+			}
+
+			bGroupPassed = bPassed != Check.bNot;
+		}
+
+		if(bGroupPassed)
+		{
+			return true;
+		}
+		GroupStart = GroupEnd;
+	}
+
+	return false;
+}
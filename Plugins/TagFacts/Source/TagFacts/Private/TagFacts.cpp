@@ -1,18 +1,55 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "TagFacts.h"
+#include "Core/FactBenchmark.h"
+#include "Core/FactJournal.h"
+#include "Data/FactExpression.h"
 
 #define LOCTEXT_NAMESPACE "FTagFactsModule"
 
 void FTagFactsModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+
+	FFactBenchmark::RegisterBenchmarkTags();
+
+	IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("TagFacts.Benchmark.GetFactValue"),
+			TEXT("TagFacts.Benchmark.GetFactValue [Facts] [Iterations]. Time GetFactValue against the old TSet<FS_Fact> lookup."),
+			FConsoleCommandWithArgsDelegate::CreateStatic(&FFactBenchmark::RunGetFactValueBenchmark));
+
+	IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("TagFacts.Benchmark.Save"),
+			TEXT("TagFacts.Benchmark.Save [Facts] [ChangedFacts]. Compare saving every fact against a journal snapshot and delta."),
+			FConsoleCommandWithArgsDelegate::CreateStatic(&FFactBenchmark::RunSaveBenchmark));
+
+	IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("TagFacts.Journal.ExportTimeline"),
+			TEXT("TagFacts.Journal.ExportTimeline [FileName]. Write every fact change of this session to Saved/TagFacts/FileName. Needs TagFacts.Journal.RecordTimeline."),
+			FConsoleCommandWithArgsDelegate::CreateStatic(&FFactJournal::ExportTimelineConsoleCommand));
+
+	IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("TagFacts.Journal.Replay"),
+			TEXT("TagFacts.Journal.Replay [FileName] [Seconds]. Replay a fact timeline from Saved/TagFacts/FileName, optionally only up to Seconds."),
+			FConsoleCommandWithArgsDelegate::CreateStatic(&FFactJournal::ReplayTimelineConsoleCommand));
+
+#if WITH_EDITOR
+	//Expressions only compile again when invalidated, any of them could have just been edited.
+	PropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddLambda([](UObject*, FPropertyChangedEvent&)
+	{
+		FFactExpression::InvalidateAll();
+	});
+#endif
 }
 
 void FTagFactsModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(PropertyChangedHandle);
+#endif
 }
 
 #undef LOCTEXT_NAMESPACE
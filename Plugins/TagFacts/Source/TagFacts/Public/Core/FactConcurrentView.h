@@ -0,0 +1,102 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include <atomic>
+
+/**Lets worker threads read facts without locks or allocations.
+ * Only the game thread writes, through FFactTable, and every change is
+ * visible to readers straight away.
+ *
+ * Slots are never removed, which keeps both halves simple:
+ * - Tags are found through an insert only, open addressing hash table keyed
+ *   on the tag name. When it fills up a bigger one is published, the old one
+ *   is kept alive until shutdown in case a reader is still probing it.
+ * - Values live in fixed size chunks that never move, one atomic per slot that
+ *   holds both the value and whether the fact exists, so a reader can never
+ *   see one without the other.*/
+class TAGFACTS_API FFactConcurrentView
+{
+public:
+
+	FFactConcurrentView() = default;
+	~FFactConcurrentView();
+
+	FFactConcurrentView(const FFactConcurrentView&) = delete;
+	FFactConcurrentView& operator=(const FFactConcurrentView&) = delete;
+
+	//Game thread
+
+	/**Make the @Slot findable through the @Tag. Called once per slot.*/
+	void AddSlot(const FGameplayTag& Tag, int32 Slot);
+
+	void Write(int32 Slot, bool bSet, int32 Value)
+	{
+		if(std::atomic<uint64>* Chunk = Chunks[Slot >> ChunkShift].load(std::memory_order_relaxed))
+		{
+			Chunk[Slot & ChunkMask].store(Pack(bSet, Value), std::memory_order_release);
+		}
+	}
+
+	//Any thread
+
+	/**Returns false if the fact doesn't exist, @OutValue is 0 in that case.*/
+	bool Read(const FGameplayTag& Tag, int32& OutValue) const;
+
+private:
+
+	static constexpr int32 ChunkShift = 12;
+	static constexpr int32 ChunkSize = 1 << ChunkShift;
+	static constexpr int32 ChunkMask = ChunkSize - 1;
+	static constexpr int32 MaxChunks = 256;
+
+	static uint64 Pack(bool bSet, int32 Value)
+	{
+		return (static_cast<uint64>(bSet) << 32) | static_cast<uint32>(Value);
+	}
+
+	/**Tag names as a single integer, 0 is never a valid tag.*/
+	static uint64 MakeKey(const FGameplayTag& Tag)
+	{
+		const FName TagName = Tag.GetTagName();
+		return (static_cast<uint64>(TagName.GetComparisonIndex().ToUnstableInt()) << 32) | static_cast<uint32>(TagName.GetNumber());
+	}
+
+	static uint32 HashKey(uint64 Key)
+	{
+		Key ^= Key >> 33;
+		Key *= 0xFF51AFD7ED558CCDull;
+		Key ^= Key >> 33;
+		return static_cast<uint32>(Key);
+	}
+
+	struct FSlotTable
+	{
+		explicit FSlotTable(int32 InCapacity);
+
+		/**Game thread only, the table must have room.*/
+		void Insert(uint64 Key, int32 Slot);
+
+		int32 Find(uint64 Key) const;
+
+		/**Always a power of two.*/
+		int32 Capacity = 0;
+		int32 Num = 0;
+
+		/**A key is written after its slot, so a reader that sees the key also sees the slot.*/
+		TUniquePtr<std::atomic<uint64>[]> Keys;
+		TUniquePtr<int32[]> Slots;
+	};
+
+	std::atomic<FSlotTable*> CurrentTable = nullptr;
+
+	/**Every table ever published, including the current one.*/
+	TArray<TUniquePtr<FSlotTable>> Tables;
+
+	/**Every key that was added, so a bigger table can be filled.*/
+	TArray<TPair<uint64, int32>> AddedKeys;
+
+	std::atomic<std::atomic<uint64>*> Chunks[MaxChunks] = {};
+};
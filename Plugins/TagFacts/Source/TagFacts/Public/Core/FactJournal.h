@@ -0,0 +1,123 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/CoreTagFactData.h"
+
+/**Versions of the fact save format.
+ * Add a new entry before VersionPlusOne whenever the format changes,
+ * and keep loading the older versions.
+ *
+ * Every blob starts with Magic, Version and an EFactSaveType. Counts are packed ints,
+ * values are an EFactValueType followed by the value itself: zigzag encoded packed ints
+ * so small negative values stay small, raw floats, packed bools and bitfields and tag names.
+ * - Snapshot: snapshot guid, then every fact as tag name and value.
+ * - Delta: guid of the snapshot it builds on, then the last change of every fact
+ *   changed since that snapshot, as tag name, whether it exists and value.
+ * - Timeline: tag name table, then every change of the session in order,
+ *   as table index, whether it exists, value and time.
+ * - TypedFacts: every fact that isn't an Int, as tag name and value. Only used
+ *   to keep those facts in save games that serialize the fact subsystem.*/
+enum class EFactSaveVersion : uint16
+{
+	Initial = 1,
+	//Values are prefixed with their EFactValueType, Initial only had Int values.
+	TypedValues,
+
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+enum class EFactSaveType : uint8
+{
+	Snapshot,
+	Delta,
+	Timeline,
+	TypedFacts
+};
+
+namespace FactSaveData
+{
+	/**"FACT", so we can tell garbage apart from an old version.*/
+	static constexpr uint32 Magic = 0x54434146;
+}
+
+/**A single change to a fact.*/
+struct FFactJournalEntry
+{
+	int32 Slot = INDEX_NONE;
+
+	/**In the format of FFactTable::GetRawValue.*/
+	int32 Value = 0;
+
+	/**Seconds since the journal was started, only used to replay a timeline.*/
+	float Time = 0;
+
+	EFactValueType Type = EFactValueType::Int;
+
+	/**False if the fact was removed.*/
+	bool bSet = false;
+};
+
+/**Log of every fact change since the last snapshot.
+ * Saves write the snapshot once and after that only the facts that changed
+ * since then, see UFactSubSystem::SaveFactSnapshot and SaveFactDelta.
+ * Only the latest change of every fact is kept, so the journal never holds
+ * more entries than there are facts, plus those changed since the savepoint.
+ * With TagFacts.Journal.RecordTimeline every change of the session is also
+ * kept in a timeline that is never compacted, so it can be replayed.*/
+class TAGFACTS_API FFactJournal
+{
+public:
+
+	void Start(bool bInRecordTimeline);
+
+	/**Record a change, replacing the previous change of the same fact
+	 * unless that one is from before the savepoint.*/
+	void Append(int32 Slot, bool bSet, int32 Value, EFactValueType Type);
+
+	/**Entries before @NumEntries are never replaced, so Truncate can go back to them.
+	 * Set while a fact transaction is running.*/
+	void SetSavepoint(int32 NumEntries) { Savepoint = NumEntries; }
+
+	/**Drop everything after the first @NumEntries entries and @NumTimelineEntries
+	 * timeline entries, used when a fact transaction is aborted.*/
+	void Truncate(int32 NumEntries, int32 NumTimelineEntries);
+
+	/**Fold every entry into a new snapshot, called once the snapshot has been saved.*/
+	void Compact();
+
+	/**Continue from a loaded snapshot and the entries of its delta.*/
+	void Restore(const FGuid& InSnapshotGuid, TArray<FFactJournalEntry>&& InEntries);
+
+	const TArray<FFactJournalEntry>& GetEntries() const { return Entries; }
+	const TArray<FFactJournalEntry>& GetTimeline() const { return Timeline; }
+	const FGuid& GetSnapshotGuid() const { return SnapshotGuid; }
+	bool IsRecordingTimeline() const { return bRecordTimeline; }
+
+	/**TagFacts.Journal.ExportTimeline [FileName]*/
+	static void ExportTimelineConsoleCommand(const TArray<FString>& Args);
+
+	/**TagFacts.Journal.Replay [FileName] [Seconds]*/
+	static void ReplayTimelineConsoleCommand(const TArray<FString>& Args);
+
+private:
+
+	/**Point LastEntryForSlot at the latest entry of every slot again.*/
+	void RebuildLastEntries();
+
+	TArray<FFactJournalEntry> Entries;
+	TArray<FFactJournalEntry> Timeline;
+
+	/**Index into Entries of the latest change of every slot, INDEX_NONE if it hasn't changed.*/
+	TArray<int32> LastEntryForSlot;
+
+	int32 Savepoint = 0;
+
+	/**Deltas can only be loaded on top of the snapshot they were made from.*/
+	FGuid SnapshotGuid;
+
+	double StartTime = 0;
+	bool bRecordTimeline = false;
+};
@@ -3,7 +3,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Core/FactJournal.h"
+#include "Core/FactTable.h"
 #include "Data/CoreTagFactData.h"
+#include "Data/FactExpression.h"
 #include "FactSubSystem.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFactAdded, FS_Fact, NewFact);
@@ -11,6 +14,91 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFactRemoved, FS_Fact, RemovedFact);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FFactIncremented, FS_Fact, Fact, int32, OldValue);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FFactDecremented, FS_Fact, Fact, int32, OldValue);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FFactOverriden, int32, OldValue, int32, NewValue);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFactTransactionCommitted, const TArray<FFactChangeEntry>&, Changes);
+
+DECLARE_DELEGATE_ThreeParams(FOnFactChanged, const FS_Fact& /*Fact*/, int32 /*OldValue*/, EFactChange /*Change*/);
+DECLARE_DYNAMIC_DELEGATE_ThreeParams(FFactChanged, FS_Fact, Fact, int32, OldValue, EFactChange, Change);
+
+/**Value of a fact from before the running transaction first changed it.*/
+struct FFactUndoEntry
+{
+	int32 Slot = INDEX_NONE;
+
+	/**In the format of FFactTable::GetRawValue.*/
+	int32 OldValue = 0;
+	EFactValueType OldType = EFactValueType::Int;
+	bool bWasSet = false;
+};
+
+/**Where a single BeginFactTransaction started, an abort cuts everything back to this.*/
+struct FFactSavepoint
+{
+	int32 JournalStart = 0;
+	int32 TimelineStart = 0;
+
+	/**Length of the UndoLog when the transaction began.*/
+	int32 UndoStart = 0;
+};
+
+struct FFactTransaction
+{
+	/**Begin calls that haven't been committed or aborted yet, innermost last.
+	 * Only the outermost commit applies.*/
+	TArray<FFactSavepoint, TInlineAllocator<4>> Savepoints;
+
+	/**Value of a fact before its first change since each savepoint, oldest first.
+	 * A fact can be in here more than once if nested transactions changed it.*/
+	TArray<FFactUndoEntry> UndoLog;
+
+	/**Slots that already have an entry in the UndoLog since the innermost savepoint.*/
+	TBitArray<> LoggedSlots;
+
+	bool IsActive() const { return !Savepoints.IsEmpty(); }
+
+	/**Mark the slots logged since the innermost savepoint, after a nested transaction ended.*/
+	void RebuildLoggedSlots()
+	{
+		LoggedSlots.Init(false, LoggedSlots.Num());
+		for(int32 CurrentEntry = Savepoints.Last().UndoStart; CurrentEntry < UndoLog.Num(); CurrentEntry++)
+		{
+			LoggedSlots[UndoLog[CurrentEntry].Slot] = true;
+		}
+	}
+
+	void Reset()
+	{
+		Savepoints.Reset();
+		UndoLog.Reset();
+		LoggedSlots.Reset();
+	}
+};
+
+/**A listener for a single fact, or every fact under a parent tag.*/
+struct FFactSubscription
+{
+	FOnFactChanged Delegate;
+
+	/**Only used by subscriptions made from blueprints.*/
+	FFactChanged DynamicDelegate;
+
+	FDelegateHandle Handle;
+
+	/**Set when unsubscribed while subscribers are being notified,
+	 * the subscription is only removed once that is done.*/
+	bool bRemoved = false;
+
+	void Notify(const FS_Fact& Fact, int32 OldValue, EFactChange Change) const
+	{
+		if(Delegate.IsBound())
+		{
+			Delegate.Execute(Fact, OldValue, Change);
+		}
+		else
+		{
+			DynamicDelegate.ExecuteIfBound(Fact, OldValue, Change);
+		}
+	}
+};
 
 UCLASS()
 class TAGFACTS_API UFactSubSystem : public UGameInstanceSubsystem
@@ -18,10 +106,62 @@ class TAGFACTS_API UFactSubSystem : public UGameInstanceSubsystem
 	GENERATED_BODY()
 
 private:
-	
+
+	/**Only filled in while the subsystem is being serialized for a save game,
+	 * the facts themselves live in the FactTable.*/
 	UPROPERTY(SaveGame)
 	TSet<FS_Fact> Facts;
 
+	/**Same as Facts, for every fact that isn't an Int. Written by WriteTypedFacts.*/
+	UPROPERTY(SaveGame)
+	TArray<uint8> TypedFacts;
+
+	FFactTable FactTable;
+
+	/**Subscriptions to a single fact, by the slot of the fact.*/
+	TMap<int32, TArray<FFactSubscription>> FactSubscriptions;
+
+	/**Subscriptions to a fact and every fact under it, by the slot of the parent.*/
+	TMap<int32, TArray<FFactSubscription>> PrefixSubscriptions;
+
+	/**Tell the subscribers of the fact in the @Slot, and of every parent of it, about a change.*/
+	void NotifyFactChanged(int32 Slot, int32 OldValue, EFactChange Change);
+
+	/**Remove every subscription in the @Slot that matches the @Predicate.
+	 * While subscribers are being notified they are only marked, so the
+	 * subscriptions being notified never move. Returns true if any matched.*/
+	bool RemoveSubscriptions(TMap<int32, TArray<FFactSubscription>>& Subscriptions, int32 Slot, TFunctionRef<bool(const FFactSubscription&)> Predicate);
+
+	/**Remove the subscriptions that were marked by RemoveSubscriptions.*/
+	void PurgeRemovedSubscriptions();
+
+	/**How many NotifyFactChanged calls are running, subscribers can cause nested ones.*/
+	int32 NotifyDepth = 0;
+
+	bool bHasRemovedSubscriptions = false;
+
+	FDelegateHandle AddSubscription(FGameplayTag Fact, bool bIncludeChildren, FFactSubscription&& Subscription);
+
+	FFactTransaction Transaction;
+
+	FFactJournal Journal;
+
+	/**Every change to the fact table goes through here, so transactions can record it.
+	 * @Value is in the format of FFactTable::GetRawValue for types other than Int.*/
+	void WriteFact(int32 Slot, bool bSet, int32 Value, EFactValueType Type = EFactValueType::Int);
+
+	/**Create the @Fact or replace its value, shared by the typed setters.
+	 * Returns true if the fact changed.*/
+	bool WriteTypedFact(FGameplayTag Fact, EFactValueType Type, int32 RawValue);
+
+	/**Every fact that isn't an Int, in the value format of the fact saves.*/
+	void WriteTypedFacts(TArray<uint8>& OutData) const;
+	void ReadTypedFacts(const TArray<uint8>& Data);
+
+	/**Fire the delegates and subscriptions for a change to the fact in the @Slot.
+	 * Does nothing during a transaction, the commit sends the net changes instead.*/
+	void BroadcastFactChange(int32 Slot, int32 OldValue, EFactChange Change);
+
 public:
 
 	UPROPERTY(Category = "Fact System", BlueprintAssignable)
@@ -39,15 +179,34 @@ public:
 	UPROPERTY(Category = "Fact System", BlueprintAssignable)
 	FFactOverriden FactOverriden;
 
+	/**Called once when a fact transaction is committed, with every fact it changed.*/
+	UPROPERTY(Category = "Fact System", BlueprintAssignable)
+	FFactTransactionCommitted FactTransactionCommitted;
+
 	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
 
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Serialize(FArchive& Ar) override;
+
+	/**Get the fact subsystem of the game instance the game viewport belongs to.*/
+	static UFactSubSystem* Get();
+
+	const FFactTable& GetFactTable() const { return FactTable; }
+
+	const FFactJournal& GetFactJournal() const { return Journal; }
+
+	/**Get the slot of the @Fact in the fact table, reserving one if the fact has never been used.*/
+	int32 FindOrAddFactSlot(FGameplayTag Fact) { return FactTable.FindOrAddSlot(Fact); }
+
 	/**The fact array is private because you are supposed to interact
-	 * with it through the helper functions.*/
+	 * with it through the helper functions.
+	 * Only contains Int facts, see GetFactValueType.*/
 	UFUNCTION(Category = "Fact System", BlueprintCallable, BlueprintPure)
-	TSet<FS_Fact> GetFacts();
+	TSet<FS_Fact> GetFacts() const;
 
 	/**Completely override the current facts with a new list.
-	 * Primarily used for loading from a save.*/
+	 * Primarily used for loading from a save. Facts of other types are removed.*/
 	UFUNCTION(Category = "Fact System", BlueprintCallable)
 	void SetFacts(TSet<FS_Fact> NewFacts);
 
@@ -74,12 +233,142 @@ public:
 	UFUNCTION(Category = "Fact System", BlueprintCallable)
 	bool OverrideFactValue(FS_Fact Fact);
 
-	/**Check the fact array and find out if the tag can be found.*/
+	/**Check the fact array and find out if the tag can be found.
+	 * Safe to call from any thread.*/
 	UFUNCTION(Category = "Fact System", BlueprintCallable, BlueprintPure)
-	bool DoesFactExist(FGameplayTag Fact);
+	bool DoesFactExist(FGameplayTag Fact) const;
 
 	/**Get the value of a fact. Will return 0 if the fact is not found.
-	 * If you need to find out if a fact has a value, use DoesFactExist instead.*/
+	 * If you need to find out if a fact has a value, use DoesFactExist instead.
+	 * Safe to call from any thread.*/
 	UFUNCTION(Category = "Fact System", BlueprintCallable, BlueprintPure)
-	int32 GetFactValue(FGameplayTag Fact);
+	int32 GetFactValue(FGameplayTag Fact) const;
+
+	/**Type of the value the @Fact holds, Int if it doesn't exist.*/
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable, BlueprintPure)
+	EFactValueType GetFactValueType(FGameplayTag Fact) const;
+
+	/**Create the @Fact or replace its value, whatever type it had before.
+	 * Returns true if the fact changed.*/
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable)
+	bool SetFactFloat(FGameplayTag Fact, float Value);
+
+	/**Value of the @Fact, 0 if it doesn't exist or isn't a Float.*/
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable, BlueprintPure)
+	float GetFactFloat(FGameplayTag Fact) const;
+
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable)
+	bool SetFactBool(FGameplayTag Fact, bool Value);
+
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable, BlueprintPure)
+	bool GetFactBool(FGameplayTag Fact) const;
+
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable)
+	bool SetFactTag(FGameplayTag Fact, FGameplayTag Value);
+
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable, BlueprintPure)
+	FGameplayTag GetFactTag(FGameplayTag Fact) const;
+
+	/**Store up to 32 flags in a single fact instead of a fact per flag.*/
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable)
+	bool SetFactBitfield(FGameplayTag Fact, int32 Bits);
+
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable, BlueprintPure)
+	int32 GetFactBitfield(FGameplayTag Fact) const;
+
+	/**Turn a single @Bit (0 to 31) of a bitfield fact on or off, creating it if needed.*/
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable)
+	bool SetFactFlag(FGameplayTag Fact, int32 Bit, bool Enabled);
+
+	UFUNCTION(Category = "Fact System|Typed", BlueprintCallable, BlueprintPure)
+	bool HasFactFlag(FGameplayTag Fact, int32 Bit) const;
+
+	/**Start batching fact changes. Facts are still changed right away,
+	 * but no delegates are called until CommitFactTransaction.
+	 * Transactions can be nested, only the outermost commit applies,
+	 * and aborting a nested one only undoes the changes made inside it.*/
+	UFUNCTION(Category = "Fact System", BlueprintCallable)
+	void BeginFactTransaction();
+
+	/**Finish the transaction and tell listeners about every fact that ended up
+	 * different, once per fact, followed by FactTransactionCommitted.
+	 * Returns false if no transaction was running.*/
+	UFUNCTION(Category = "Fact System", BlueprintCallable)
+	bool CommitFactTransaction();
+
+	/**Undo every change made since the innermost BeginFactTransaction that is still open,
+	 * without calling any delegates. Outer transactions keep running.
+	 * Returns false if no transaction was running.*/
+	UFUNCTION(Category = "Fact System", BlueprintCallable)
+	bool AbortFactTransaction();
+
+	UFUNCTION(Category = "Fact System", BlueprintCallable, BlueprintPure)
+	bool IsInFactTransaction() const { return Transaction.IsActive(); }
+
+	/**Does the @Expression pass with the current facts?*/
+	UFUNCTION(Category = "Fact System", BlueprintCallable, BlueprintPure)
+	bool EvaluateFactExpression(const FFactExpression& Expression);
+
+	/**Write every fact into @OutData and start a new snapshot.
+	 * Deltas saved after this can only be loaded on top of this snapshot.
+	 * Fails while a fact transaction is running.
+	 * The format is described in FactJournal.h*/
+	UFUNCTION(Category = "Fact System|Save", BlueprintCallable)
+	bool SaveFactSnapshot(TArray<uint8>& OutData);
+
+	/**Write only the facts that changed since the last SaveFactSnapshot into @OutData.
+	 * Much smaller than a snapshot when few facts change between saves.*/
+	UFUNCTION(Category = "Fact System|Save", BlueprintCallable)
+	bool SaveFactDelta(TArray<uint8>& OutData) const;
+
+	/**Replace the current facts with the @Snapshot and the @Delta saved on top of it.
+	 * @Delta can be empty. Like SetFacts, this doesn't call any delegates.
+	 * Fails while a fact transaction is running.*/
+	UFUNCTION(Category = "Fact System|Save", BlueprintCallable)
+	bool LoadFactSave(const TArray<uint8>& Snapshot, const TArray<uint8>& Delta);
+
+	/**True once the journal has grown past TagFacts.Journal.SnapshotThreshold,
+	 * at which point the next save should be a snapshot instead of a delta.*/
+	UFUNCTION(Category = "Fact System|Save", BlueprintCallable, BlueprintPure)
+	bool ShouldSaveFactSnapshot() const;
+
+	/**Write every fact change of this session, if TagFacts.Journal.RecordTimeline was on when it started.*/
+	bool SaveFactTimeline(TArray<uint8>& OutData) const;
+
+	/**Clear the facts and apply the changes of a timeline in order, calling every
+	 * delegate along the way. Stops after @UpToTime seconds if it isn't negative.
+	 * Fails while a fact transaction is running.*/
+	bool ReplayFactTimeline(const TArray<uint8>& Data, float UpToTime = -1);
+
+	/**Sum of the values of the @Parent fact and every fact under it.
+	 * For example, Kills.Bandit adds up Kills.Bandit.Archer and Kills.Bandit.Melee.*/
+	UFUNCTION(Category = "Fact System|Aggregates", BlueprintCallable, BlueprintPure)
+	int64 GetFactSum(FGameplayTag Parent) const;
+
+	/**Amount of facts that exist at or under the @Parent fact.*/
+	UFUNCTION(Category = "Fact System|Aggregates", BlueprintCallable, BlueprintPure)
+	int32 GetFactCount(FGameplayTag Parent) const;
+
+	/**Highest value of the @Parent fact and every fact under it, 0 if none exist.*/
+	UFUNCTION(Category = "Fact System|Aggregates", BlueprintCallable, BlueprintPure)
+	int32 GetFactMax(FGameplayTag Parent) const;
+
+	/**Native subscription to changes of the @Fact. Only this fact wakes the @Delegate up,
+	 * unlike the global delegates above. Returns a handle to pass to UnsubscribeFromFact.*/
+	FDelegateHandle SubscribeToFact(FGameplayTag Fact, FOnFactChanged Delegate);
+
+	/**Native subscription to the @Parent fact and every fact under it.
+	 * Subscribing to Kills.Bandit is told about Kills.Bandit.Archer.*/
+	FDelegateHandle SubscribeToFactPrefix(FGameplayTag Parent, FOnFactChanged Delegate);
+
+	/**Remove a subscription made with SubscribeToFact or SubscribeToFactPrefix for the same @Fact.*/
+	bool UnsubscribeFromFact(FGameplayTag Fact, FDelegateHandle Handle);
+
+	/**Get told whenever the @Fact changes. If @IncludeChildren is true,
+	 * every fact under the @Fact will also call the @Delegate.*/
+	UFUNCTION(Category = "Fact System", BlueprintCallable)
+	void BindToFact(FGameplayTag Fact, bool IncludeChildren, FFactChanged Delegate);
+
+	UFUNCTION(Category = "Fact System", BlueprintCallable)
+	void UnbindFromFact(FGameplayTag Fact, FFactChanged Delegate);
 };
@@ -0,0 +1,228 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Core/FactConcurrentView.h"
+#include "Data/CoreTagFactData.h"
+
+/**Flat storage for every fact in the fact system.
+ * Each tag is given a slot the first time it is used and keeps it for
+ * the rest of the session. Removing a fact only marks its slot as unset,
+ * so a slot can be cached and read later without looking up the tag again.
+ * Int values live in a dense column, other types each get a column of their own
+ * that only grows as far as the highest slot that ever held that type.
+ * Everything except the *_AnyThread functions is game thread only.*/
+class TAGFACTS_API FFactTable
+{
+public:
+
+	static constexpr int32 InvalidSlot = INDEX_NONE;
+
+	/**Get the slot for the @Tag, or InvalidSlot if it was never used.*/
+	int32 FindSlot(const FGameplayTag& Tag) const
+	{
+		const int32* FoundSlot = TagToSlot.Find(Tag);
+		return FoundSlot ? *FoundSlot : InvalidSlot;
+	}
+
+	/**Get the slot for the @Tag, giving it one if this is its first use.*/
+	int32 FindOrAddSlot(const FGameplayTag& Tag);
+
+	/**Does the fact in the @Slot currently exist?*/
+	bool IsSet(int32 Slot) const
+	{
+		return SetSlots.IsValidIndex(Slot) && SetSlots[Slot];
+	}
+
+	/**Value of the fact in the @Slot, 0 if it isn't set or isn't an Int.*/
+	int32 GetValue(int32 Slot) const
+	{
+		return IsSet(Slot) ? Values[Slot] : 0;
+	}
+
+	/**Type of the fact in the @Slot, Int if it isn't set.*/
+	EFactValueType GetValueType(int32 Slot) const
+	{
+		return IsSet(Slot) ? SlotTypes[Slot] : EFactValueType::Int;
+	}
+
+	float GetFloatValue(int32 Slot) const
+	{
+		return IsSetAs(Slot, EFactValueType::Float) ? FloatValues[Slot] : 0;
+	}
+
+	bool GetBoolValue(int32 Slot) const
+	{
+		return IsSetAs(Slot, EFactValueType::Bool) && BoolValues[Slot];
+	}
+
+	FGameplayTag GetTagValue(int32 Slot) const
+	{
+		return IsSetAs(Slot, EFactValueType::Tag) ? GetTag(TagValues[Slot]) : FGameplayTag::EmptyTag;
+	}
+
+	uint32 GetBitfieldValue(int32 Slot) const
+	{
+		return IsSetAs(Slot, EFactValueType::Bitfield) ? BitfieldValues[Slot] : 0;
+	}
+
+	/**Value of the fact in the @Slot as 32 bits, whatever its type.
+	 * Floats are their bits and tags are the slot of the tag.
+	 * Lets journals and undo logs record any fact without caring about its type.*/
+	int32 GetRawValue(int32 Slot) const;
+
+	FGameplayTag GetTag(int32 Slot) const
+	{
+		return SlotTags.IsValidIndex(Slot) ? SlotTags[Slot] : FGameplayTag::EmptyTag;
+	}
+
+	/**Slot of the direct parent tag of the @Slot, or InvalidSlot for root tags.
+	 * Parents are always given a slot before their children.*/
+	int32 GetParentSlot(int32 Slot) const
+	{
+		return ParentSlots.IsValidIndex(Slot) ? ParentSlots[Slot] : InvalidSlot;
+	}
+
+	/**Create or overwrite the fact in the @Slot with an Int.*/
+	void SetValue(int32 Slot, int32 Value);
+
+	/**Create or overwrite the fact in the @Slot with any type,
+	 * @RawValue is in the format of GetRawValue.
+	 * Other types count as 0 towards the aggregates.*/
+	void SetRawValue(int32 Slot, EFactValueType Type, int32 RawValue);
+
+	void SetFloatValue(int32 Slot, float Value) { SetRawValue(Slot, EFactValueType::Float, FloatToRaw(Value)); }
+	void SetBoolValue(int32 Slot, bool bValue) { SetRawValue(Slot, EFactValueType::Bool, bValue); }
+	void SetBitfieldValue(int32 Slot, uint32 Value) { SetRawValue(Slot, EFactValueType::Bitfield, static_cast<int32>(Value)); }
+
+	/**The @TagSlot has to be a slot of this table, or InvalidSlot for an empty tag.*/
+	void SetTagValue(int32 Slot, int32 TagSlot) { SetRawValue(Slot, EFactValueType::Tag, TagSlot); }
+
+	static int32 FloatToRaw(float Value)
+	{
+		int32 RawValue;
+		FMemory::Memcpy(&RawValue, &Value, sizeof(RawValue));
+		return RawValue;
+	}
+
+	static float RawToFloat(int32 RawValue)
+	{
+		float Value;
+		FMemory::Memcpy(&Value, &RawValue, sizeof(Value));
+		return Value;
+	}
+
+	/**Remove the fact in the @Slot, the slot stays reserved for its tag.*/
+	void Unset(int32 Slot);
+
+	/**Remove every fact, slots stay reserved for their tags.*/
+	void Reset();
+
+	/**Bumped every time any fact is set, changed or removed.*/
+	uint32 GetRevision() const { return Revision; }
+
+	/**Value of GetRevision when the fact in the @Slot last changed.*/
+	uint32 GetSlotRevision(int32 Slot) const
+	{
+		return SlotRevisions.IsValidIndex(Slot) ? SlotRevisions[Slot] : 0;
+	}
+
+	/**Sum of the values of the fact in the @Slot and every fact under it.
+	 * Kept up to date on every change, so this is a single read.*/
+	int64 GetSubtreeSum(int32 Slot) const
+	{
+		return SubtreeSums.IsValidIndex(Slot) ? SubtreeSums[Slot] : 0;
+	}
+
+	/**Amount of facts that exist in the @Slot and under it.*/
+	int32 GetSubtreeCount(int32 Slot) const
+	{
+		return SubtreeCounts.IsValidIndex(Slot) ? SubtreeCounts[Slot] : 0;
+	}
+
+	/**Highest value of the facts in the @Slot and under it, 0 if none exist.
+	 * Lowering or removing the current highest value can't be handled incrementally,
+	 * that marks the max as stale and the next call walks the subtree once.*/
+	int32 GetSubtreeMax(int32 Slot) const;
+
+	/**Read the fact for the @Tag from any thread, without locking or allocating.
+	 * Returns false if it doesn't exist, @OutValue is 0 in that case.*/
+	bool ReadFact_AnyThread(const FGameplayTag& Tag, int32& OutValue) const
+	{
+		return ConcurrentView.Read(Tag, OutValue);
+	}
+
+	/**Amount of facts that currently exist.*/
+	int32 Num() const { return NumSet; }
+
+	/**Amount of slots handed out, set or not.*/
+	int32 NumSlots() const { return SlotTags.Num(); }
+
+	/**Call @Callback with the slot of every fact that currently exists.*/
+	template<typename CallbackType>
+	void ForEachSetSlot(CallbackType&& Callback) const
+	{
+		for(TConstSetBitIterator<> It(SetSlots); It; ++It)
+		{
+			Callback(It.GetIndex());
+		}
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T ChildBytes = ChildSlots.GetAllocatedSize();
+		for(const TArray<int32>& Children : ChildSlots)
+		{
+			ChildBytes += Children.GetAllocatedSize();
+		}
+		
+		return TagToSlot.GetAllocatedSize() + SlotTags.GetAllocatedSize() + ParentSlots.GetAllocatedSize()
+			+ Values.GetAllocatedSize() + SetSlots.GetAllocatedSize() + SlotTypes.GetAllocatedSize()
+			+ FloatValues.GetAllocatedSize() + BoolValues.GetAllocatedSize() + TagValues.GetAllocatedSize() + BitfieldValues.GetAllocatedSize() + SlotRevisions.GetAllocatedSize() + ChildBytes
+			+ SubtreeSums.GetAllocatedSize() + SubtreeCounts.GetAllocatedSize() + SubtreeMaxes.GetAllocatedSize() + StaleMaxes.GetAllocatedSize();
+	}
+
+private:
+
+	bool IsSetAs(int32 Slot, EFactValueType Type) const
+	{
+		return IsSet(Slot) && SlotTypes[Slot] == Type;
+	}
+
+	/**Apply a change of the fact in the @Slot to its own and every parents aggregates.*/
+	void UpdateAggregates(int32 Slot, bool bWasSet, int32 OldValue, bool bIsSet, int32 NewValue);
+
+	/**Highest set value in the subtree of the @Slot, walked through ChildSlots.*/
+	int32 ComputeSubtreeMax(int32 Slot) const;
+
+	TMap<FGameplayTag, int32> TagToSlot;
+
+	/**Per slot columns, indexed by the slot.*/
+	TArray<FGameplayTag> SlotTags;
+	TArray<int32> ParentSlots;
+	TArray<int32> Values;
+	TBitArray<> SetSlots;
+	TArray<EFactValueType> SlotTypes;
+	TArray<uint32> SlotRevisions;
+	TArray<TArray<int32>> ChildSlots;
+
+	/**Columns for the other types, only valid where SlotTypes says so.*/
+	TArray<float> FloatValues;
+	TBitArray<> BoolValues;
+	TArray<int32> TagValues;
+	TArray<uint32> BitfieldValues;
+
+	/**Aggregates of every slot over itself and everything under it.*/
+	TArray<int64> SubtreeSums;
+	TArray<int32> SubtreeCounts;
+	mutable TArray<int32> SubtreeMaxes;
+	mutable TBitArray<> StaleMaxes;
+
+	/**Mirror of the Values and SetSlots columns for other threads.*/
+	FFactConcurrentView ConcurrentView;
+
+	int32 NumSet = 0;
+	uint32 Revision = 0;
+};
@@ -13,6 +13,55 @@ enum EFactComparator
 	IsFactGreaterThan,
 	IsFactLessThan,
 	IsFactEqualTo,
+	IsFactInRange, //Is the value between the value to compare and the max value, inclusive
+};
+
+/**The net change a committed fact transaction made to a single fact.*/
+USTRUCT(BlueprintType)
+struct FFactChangeEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fact")
+	FGameplayTag Tag;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fact")
+	int32 OldValue = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fact")
+	int32 NewValue = 0;
+
+	/**Did the fact exist before the transaction?*/
+	UPROPERTY(BlueprintReadOnly, Category = "Fact")
+	bool Existed = false;
+
+	/**Does the fact exist after the transaction?*/
+	UPROPERTY(BlueprintReadOnly, Category = "Fact")
+	bool Exists = false;
+};
+
+/**What happened to a fact, passed to fact subscriptions.*/
+UENUM(BlueprintType)
+enum class EFactChange : uint8
+{
+	Added,
+	Removed,
+	Incremented,
+	Decremented,
+	Overridden
+};
+
+/**What kind of value a fact holds. A fact has a single type at a time,
+ * setting it through another type replaces the old value.
+ * The int fact functions only ever see Int facts, others read as 0.*/
+UENUM(BlueprintType)
+enum class EFactValueType : uint8
+{
+	Int,
+	Float,
+	Bool,
+	Tag,
+	Bitfield
 };
 
 //V: This is unused, remove this?
@@ -39,13 +88,13 @@ struct FS_Fact
 		return Argument.Tag == Tag;
 	}
 };
+/**Facts are equal when their tags are, so only the tag can be part of the hash.*/
 FORCEINLINE uint32 GetTypeHash(const FS_Fact& Thing)
 {
-	uint32 Hash = FCrc::MemCrc32(&Thing, sizeof(FS_Fact));
-	return Hash;
+	return GetTypeHash(Thing.Tag);
 }
 
-//V: This is unused, remove this?
+/**A single condition of a fact expression, see FactExpression.h*/
 USTRUCT(BlueprintType)
 struct FFactCheck
 {
@@ -65,4 +114,12 @@ struct FFactCheck
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fact", meta = (EditCondition="Type == EFactType::Value", EditConditionHides))
 	int32 ValueToCompare = 0;
+
+	/**Upper bound used by IsFactInRange, ValueToCompare is the lower bound.*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fact", meta = (EditCondition="CheckToPerform == EFactComparator::IsFactInRange", EditConditionHides))
+	int32 MaxValueToCompare = 0;
+
+	/**Invert the result of the check.*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fact")
+	bool Not = false;
 };
@@ -17,4 +17,9 @@ class TAGFACTS_API UFL_TagFactLibrary : public UBlueprintFunctionLibrary
 
 	UFUNCTION(Category = "TagFacts|Comparitors", BlueprintCallable, BlueprintPure)
 	static bool CompareFact(FS_Fact Fact, int32 Value, TEnumAsByte<EFactComparator> Comparator);
+
+	/**Replace the checks of the @Expression and make it compile them again.
+	 * Use this instead of Set Members, the expression can't tell its checks were changed that way.*/
+	UFUNCTION(Category = "TagFacts|Expressions", BlueprintCallable)
+	static void SetFactExpressionChecks(UPARAM(ref) FFactExpression& Expression, const TArray<FFactCheckGroup>& AnyOf);
 };
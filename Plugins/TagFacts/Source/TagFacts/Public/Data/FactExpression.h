@@ -0,0 +1,91 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoreTagFactData.h"
+#include "FactExpression.generated.h"
+
+class UFactSubSystem;
+
+/**Every check in the group has to pass for the group to pass.*/
+USTRUCT(BlueprintType)
+struct FFactCheckGroup
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fact")
+	TArray<FFactCheck> Checks;
+};
+
+/**A fact check resolved to the slots of the fact table, see FFactTable.*/
+struct FCompiledFactCheck
+{
+	int32 Slot = INDEX_NONE;
+
+	/**Slot of the fact to compare against, INDEX_NONE when comparing against Value.*/
+	int32 OtherSlot = INDEX_NONE;
+
+	int32 Value = 0;
+	int32 MaxValue = 0;
+	EFactComparator Comparator = IsTrue;
+	bool bNot = false;
+};
+
+/**A condition made up of fact checks, for dialogue and quest requirements.
+ * The expression passes if any of its groups pass (OR), and a group passes
+ * if all of its checks pass (AND). Checks can be inverted (NOT), which is
+ * enough to write any combination of checks.
+ *
+ * The first evaluation compiles the checks into a flat array of fact slots,
+ * every evaluation after that reads the fact table directly without allocating.
+ * Changing the checks in place at runtime needs an Invalidate afterwards,
+ * blueprints can use SetFactExpressionChecks. Editing any property in the
+ * editor invalidates every expression.*/
+USTRUCT(BlueprintType)
+struct TAGFACTS_API FFactExpression
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fact")
+	TArray<FFactCheckGroup> AnyOf;
+
+	/**Reuse the last result until one of the facts this expression
+	 * reads has changed, instead of evaluating every time.*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fact")
+	bool Memoize = false;
+
+	bool Evaluate(UFactSubSystem& FactSubSystem) const;
+
+	/**Throw away the compiled checks and the memoized result.*/
+	void Invalidate() const;
+
+	/**Make every expression compile again on its next evaluation.*/
+	static void InvalidateAll() { Generation++; }
+
+private:
+
+	void Compile(UFactSubSystem& FactSubSystem) const;
+	bool EvaluateCompiled(const UFactSubSystem& FactSubSystem) const;
+
+	/**Bumped by InvalidateAll.*/
+	static uint32 Generation;
+
+	/**Subsystem the slots were resolved against, they mean nothing in another one.*/
+	mutable TWeakObjectPtr<const UFactSubSystem> CompiledFor;
+
+	/**Generation from when the checks were compiled.*/
+	mutable uint32 CompiledGeneration = 0;
+
+	mutable TArray<FCompiledFactCheck> CompiledChecks;
+
+	/**One past the last check of every group, in CompiledChecks.*/
+	mutable TArray<int32> GroupEnds;
+
+	/**Every slot the expression reads, without duplicates. Used by Memoize.*/
+	mutable TArray<int32> ReferencedSlots;
+
+	mutable uint32 EvaluatedRevision = 0;
+	mutable bool bHasResult = false;
+	mutable bool bResult = false;
+};
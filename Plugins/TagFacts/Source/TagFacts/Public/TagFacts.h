@@ -12,4 +12,10 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+private:
+
+#if WITH_EDITOR
+	FDelegateHandle PropertyChangedHandle;
+#endif
 };
@@ -8,66 +8,120 @@ UDS_TagMetadata::UDS_TagMetadata()
 	CategoryName = "Plugins";
 }
 
-TArray<UO_TagMetadata*> UDS_TagMetadata::GetTagMetadata(FGameplayTag Tag, TSoftClassPtr<UO_TagMetadataCollection> OptionalCollection)
+const FTagMetadataIndex& UDS_TagMetadata::GetIndex()
 {
-	TArray<UO_TagMetadata*> FoundMetadata;
-
-	if(!OptionalCollection.IsNull())
+	UDS_TagMetadata* TagMetadataConfig = GetMutableDefault<UDS_TagMetadata>();
+	if(!TagMetadataConfig->Index.bBuilt)
 	{
-		TSubclassOf<UO_TagMetadataCollection> LoadedClass = OptionalCollection.LoadSynchronous();
-		for(auto& CurrentMetadata : Cast<UO_TagMetadataCollection>(LoadedClass->ClassDefaultObject)->TagsMetadata)
+		TRACE_CPUPROFILER_EVENT_SCOPE(BuildTagMetadataIndex)
+		TagMetadataConfig->Index.bBuilt = true;
+		for(auto& CurrentCollection : TagMetadataConfig->TagMetadataCollections)
 		{
-			if(CurrentMetadata.Tag == Tag)
-			{
-				FoundMetadata.Append(CurrentMetadata.Metadata);
-			}
+			TagMetadataConfig->IndexCollection(CurrentCollection, true);
 		}
+	}
+
+	return TagMetadataConfig->Index;
+}
 
-		return FoundMetadata;
+void UDS_TagMetadata::IndexCollection(const TSoftClassPtr<UO_TagMetadataCollection>& Collection, bool bInSettings)
+{
+	if(Collection.IsNull())
+	{
+		return;
 	}
-	
-	if(const UDS_TagMetadata* TagMetadataConfig = GetDefault<UDS_TagMetadata>())
+
+	//This is the only place that loads collections, lookups only ever read the index.
+	const TSubclassOf<UO_TagMetadataCollection> LoadedClass = Collection.LoadSynchronous();
+	if(!LoadedClass)
 	{
-		for(auto& CurrentCollection : TagMetadataConfig->TagMetadataCollections)
+		return;
+	}
+
+	const bool bAlreadyIndexed = IndexedCollections.Contains(LoadedClass.Get());
+	if(bAlreadyIndexed && !bInSettings)
+	{
+		return;
+	}
+	IndexedCollections.AddUnique(LoadedClass.Get());
+
+	for(const FTagMetadata& CurrentMetadata : LoadedClass.GetDefaultObject()->TagsMetadata)
+	{
+		if(!bAlreadyIndexed)
 		{
-			if(!CurrentCollection.IsNull())
+			Index.CollectionMetadata.FindOrAdd(TPair<const UClass*, FGameplayTag>(LoadedClass.Get(), CurrentMetadata.Tag)).Append(CurrentMetadata.Metadata);
+		}
+
+		if(!bInSettings)
+		{
+			continue;
+		}
+
+		Index.Metadata.FindOrAdd(CurrentMetadata.Tag).Append(CurrentMetadata.Metadata);
+		Index.Collections.FindOrAdd(CurrentMetadata.Tag).AddUnique(LoadedClass);
+		for(UO_TagMetadata* Metadata : CurrentMetadata.Metadata)
+		{
+			//Earlier collections win, same as the old linear search.
+			const TPair<FGameplayTag, const UClass*> Key(CurrentMetadata.Tag, IsValid(Metadata) ? Metadata->GetClass() : nullptr);
+			if(Key.Value && !Index.MetadataByClass.Contains(Key))
 			{
-				TSubclassOf<UO_TagMetadataCollection> LoadedClass = CurrentCollection.LoadSynchronous();
-				for(auto& CurrentMetadata : Cast<UO_TagMetadataCollection>(LoadedClass->ClassDefaultObject)->TagsMetadata)
-				{
-					if(CurrentMetadata.Tag == Tag)
-					{
-						FoundMetadata.Append(CurrentMetadata.Metadata);
-					}
-				}
+				Index.MetadataByClass.Add(Key, Metadata);
 			}
 		}
 	}
-	
-	return FoundMetadata;
 }
 
-UO_TagMetadata* UDS_TagMetadata::GetTagMetadataByClass(FGameplayTag Tag, TSubclassOf<UO_TagMetadata> Class)
+TConstArrayView<UO_TagMetadata*> UDS_TagMetadata::FindTagMetadata(FGameplayTag Tag)
 {
-	for(TArray<UO_TagMetadata*> TagMetadata = GetTagMetadata(Tag); const auto& CurrentMetadata : TagMetadata)
+	if(const TArray<UO_TagMetadata*>* FoundMetadata = GetIndex().Metadata.Find(Tag))
 	{
-		if(IsValid(CurrentMetadata))
-		{
-			if(CurrentMetadata->GetClass() == Class)
-			{
-				return CurrentMetadata;
-			}
-		}
+		return *FoundMetadata;
 	}
 
-	return nullptr;
+	return {};
+}
+
+TConstArrayView<UO_TagMetadata*> UDS_TagMetadata::FindCollectionMetadata(FGameplayTag Tag, const TSoftClassPtr<UO_TagMetadataCollection>& Collection)
+{
+	GetIndex();
+	UDS_TagMetadata* TagMetadataConfig = GetMutableDefault<UDS_TagMetadata>();
+
+	//Collections that aren't in the settings are indexed the first time they're asked for.
+	const UClass* CollectionClass = Collection.Get();
+	if(!CollectionClass || !TagMetadataConfig->IndexedCollections.Contains(CollectionClass))
+	{
+		TagMetadataConfig->IndexCollection(Collection, false);
+		CollectionClass = Collection.Get();
+	}
+
+	if(const TArray<UO_TagMetadata*>* FoundMetadata = TagMetadataConfig->Index.CollectionMetadata.Find({CollectionClass, Tag}))
+	{
+		return *FoundMetadata;
+	}
+
+	return {};
+}
+
+TArray<UO_TagMetadata*> UDS_TagMetadata::GetTagMetadata(FGameplayTag Tag, TSoftClassPtr<UO_TagMetadataCollection> OptionalCollection)
+{
+	if(!OptionalCollection.IsNull())
+	{
+		return TArray<UO_TagMetadata*>(FindCollectionMetadata(Tag, OptionalCollection));
+	}
+
+	return TArray<UO_TagMetadata*>(FindTagMetadata(Tag));
+}
+
+UO_TagMetadata* UDS_TagMetadata::GetTagMetadataByClass(FGameplayTag Tag, TSubclassOf<UO_TagMetadata> Class)
+{
+	return GetIndex().MetadataByClass.FindRef({Tag, Class.Get()});
 }
 
 UO_TagMetadata* UDS_TagMetadata::GetTagMetadataByClassFromCollection(FGameplayTag Tag,
 	TSubclassOf<UO_TagMetadata> Class, TSoftClassPtr<UO_TagMetadataCollection> Collection)
 {
-	TArray<UO_TagMetadata*> TagMetadata = GetTagMetadata(Tag, Collection);
-	for(const auto& CurrentMetadata : TagMetadata)
+	//A single collection only has a handful of metadata per tag, not worth its own map.
+	for(UO_TagMetadata* CurrentMetadata : FindCollectionMetadata(Tag, Collection))
 	{
 		if(IsValid(CurrentMetadata))
 		{
@@ -83,23 +137,23 @@ UO_TagMetadata* UDS_TagMetadata::GetTagMetadataByClassFromCollection(FGameplayTa
 
 TArray<TSubclassOf<UO_TagMetadataCollection>> UDS_TagMetadata::GetAllCollectionsForTag(FGameplayTag Tag)
 {
-	TArray<TSubclassOf<UO_TagMetadataCollection>> FoundCollections;
-	
-	if(const UDS_TagMetadata* TagMetadataConfig = GetDefault<UDS_TagMetadata>())
-	{
-		for(auto& CurrentCollection : TagMetadataConfig->TagMetadataCollections)
-		{
-			TSubclassOf<UO_TagMetadataCollection> LoadedClass = CurrentCollection.LoadSynchronous();
-			for(auto& CurrentTagMetadata : LoadedClass.GetDefaultObject()->TagsMetadata)
-			{
-				if(CurrentTagMetadata.Tag == Tag)
-				{
-					FoundCollections.Add(CurrentCollection.Get());
-					break;
-				}
-			}
-		}
-	}
+	return GetIndex().Collections.FindRef(Tag);
+}
+
+void UDS_TagMetadata::InvalidateIndex()
+{
+	UDS_TagMetadata* TagMetadataConfig = GetMutableDefault<UDS_TagMetadata>();
+	TagMetadataConfig->Index = FTagMetadataIndex();
+	TagMetadataConfig->IndexedCollections.Reset();
+}
 
-	return FoundCollections;
+#if WITH_EDITOR
+
+void UDS_TagMetadata::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	InvalidateIndex();
 }
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "TagMetadata/Public/O_TagMetadataCollection.h"
 
+#include "TagMetadata/Public/DS_TagMetadata.h"
+
 #if WITH_EDITOR
 #include "Framework/Notifications/NotificationManager.h"
 #include "Widgets/Notifications/SNotificationList.h"
@@ -24,6 +26,8 @@ void UO_TagMetadataCollection::PostEditChangeChainProperty(FPropertyChangedChain
 {
 	Super::PostEditChangeChainProperty(PropertyChangedEvent);
 
+	UDS_TagMetadata::InvalidateIndex();
+
 	if (PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(FTagMetadata, Tag))
 	{
 		int32 TagIndex = PropertyChangedEvent.GetArrayIndex(PropertyChangedEvent.PropertyChain.GetActiveMemberNode()->GetValue()->GetFName().ToString());
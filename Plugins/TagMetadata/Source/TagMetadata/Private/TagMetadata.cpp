@@ -2,17 +2,38 @@
 
 #include "TagMetadata.h"
 
+#include "TagMetadata/Public/DS_TagMetadata.h"
+
 #define LOCTEXT_NAMESPACE "FTagMetadataModule"
 
 void FTagMetadataModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+
+#if WITH_EDITOR
+	//Recompiling a collection blueprint replaces its defaults, which the metadata index points into.
+	ObjectsReinstancedHandle = FCoreUObjectDelegates::OnObjectsReinstanced.AddLambda([](const TMap<UObject*, UObject*>& OldToNewObjects)
+	{
+		for(const TPair<UObject*, UObject*>& CurrentObject : OldToNewObjects)
+		{
+			if(CurrentObject.Key && CurrentObject.Key->IsA<UO_TagMetadataCollection>())
+			{
+				UDS_TagMetadata::InvalidateIndex();
+				return;
+			}
+		}
+	});
+#endif
 }
 
 void FTagMetadataModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectsReinstanced.Remove(ObjectsReinstancedHandle);
+#endif
 }
 
 #undef LOCTEXT_NAMESPACE
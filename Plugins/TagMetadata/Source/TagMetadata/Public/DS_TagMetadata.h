@@ -9,6 +9,26 @@
 #include "TagMetadata/Public/O_TagMetadataCollection.h"
 #include "DS_TagMetadata.generated.h"
 
+/**Lookup tables built once from every collection in the settings,
+ * so finding the metadata of a tag doesn't have to load or scan the collections.*/
+struct FTagMetadataIndex
+{
+	/**Every metadata of a tag across all collections, in collection order.*/
+	TMap<FGameplayTag, TArray<UO_TagMetadata*>> Metadata;
+
+	/**The first metadata of a class for a tag, in the same order as Metadata.*/
+	TMap<TPair<FGameplayTag, const UClass*>, UO_TagMetadata*> MetadataByClass;
+
+	/**Every collection that has the tag.*/
+	TMap<FGameplayTag, TArray<TSubclassOf<UO_TagMetadataCollection>>> Collections;
+
+	/**Metadata of a tag in a single collection, also holds collections
+	 * that were asked for directly but aren't in the settings.*/
+	TMap<TPair<const UClass*, FGameplayTag>, TArray<UO_TagMetadata*>> CollectionMetadata;
+
+	bool bBuilt = false;
+};
+
 /**
  * Metadata system to extend the usage of GameplayTags.
  * 
@@ -22,6 +42,22 @@ class TAGMETADATA_API UDS_TagMetadata : public UDeveloperSettings
 
 	UDS_TagMetadata();
 
+	FTagMetadataIndex Index;
+
+	/**Keeps the indexed collections loaded, the index points into their defaults.*/
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UClass>> IndexedCollections;
+
+	/**Get the index, building it if this is the first lookup since it was invalidated.*/
+	static const FTagMetadataIndex& GetIndex();
+
+	/**Add the metadata of the @Collection to the index, loading it if it isn't already.
+	 * If @bInSettings is false, only CollectionMetadata is filled in.*/
+	void IndexCollection(const TSoftClassPtr<UO_TagMetadataCollection>& Collection, bool bInSettings);
+
+	/**Metadata of the @Tag in the @Collection, indexing the collection if it hasn't been yet.*/
+	static TConstArrayView<UO_TagMetadata*> FindCollectionMetadata(FGameplayTag Tag, const TSoftClassPtr<UO_TagMetadataCollection>& Collection);
+
 public:
 
 	/**Friendly texts for tags, which can be picked up by the translation tool
@@ -49,4 +85,18 @@ public:
 	/**Returns all collections where the @Tag is being used.*/
 	UFUNCTION(Category = "Tags Metadata", BlueprintCallable, BlueprintPure)
 	static TArray<TSubclassOf<UO_TagMetadataCollection>> GetAllCollectionsForTag(FGameplayTag Tag);
+
+	/**Same as GetTagMetadata without a collection, but without copying the result.
+	 * Meant for code that looks metadata up every frame.*/
+	static TConstArrayView<UO_TagMetadata*> FindTagMetadata(FGameplayTag Tag);
+
+	/**Throw away the lookup index, the next lookup rebuilds it.
+	 * Call this after changing a collection in a way the editor doesn't see,
+	 * like modifying its class defaults from an editor utility widget.*/
+	UFUNCTION(Category = "Tags Metadata", BlueprintCallable)
+	static void InvalidateIndex();
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 };